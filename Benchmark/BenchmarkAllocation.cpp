@@ -0,0 +1,66 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "BenchmarkAllocation.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace QDPF
+{
+	namespace Benchmark
+	{
+
+		static std::atomic<std::size_t> numAllocationsCounter{ 0 }, numBytesCounter{ 0 };
+
+		void ReadAllocationCounts(std::size_t& numAllocations, std::size_t& numBytes)
+		{
+			numAllocations = numAllocationsCounter.load(std::memory_order_relaxed);
+			numBytes = numBytesCounter.load(std::memory_order_relaxed);
+		}
+
+		static void* CountedAllocate(std::size_t n)
+		{
+			numAllocationsCounter.fetch_add(1, std::memory_order_relaxed);
+			numBytesCounter.fetch_add(n, std::memory_order_relaxed);
+			void* p = std::malloc(n == 0 ? 1 : n);
+			if (p == nullptr)
+				throw std::bad_alloc();
+			return p;
+		}
+
+	} // namespace Benchmark
+} // namespace QDPF
+
+// ~~~~~~~~~~~~ Replaced global operator new and delete ~~~~~~~~~~~~~~~
+
+void* operator new(std::size_t n)
+{
+	return QDPF::Benchmark::CountedAllocate(n);
+}
+
+void* operator new[](std::size_t n)
+{
+	return QDPF::Benchmark::CountedAllocate(n);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
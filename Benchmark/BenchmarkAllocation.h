@@ -0,0 +1,26 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// Allocation counting for the benchmark executables.
+// The global operator new and delete are replaced in BenchmarkAllocation.cpp, compile it only into
+// executables that need to count allocations.
+// **NOTE**: This file is NOT required to use quadtree-pathfinding.
+
+#ifndef QDPF_BENCHMARK_ALLOCATION_HPP
+#define QDPF_BENCHMARK_ALLOCATION_HPP
+
+#include <cstddef>
+
+namespace QDPF
+{
+	namespace Benchmark
+	{
+
+		// Reads the number of allocations and allocated bytes since the process started.
+		// Its signature matches QDPF::AllocationCounter.
+		void ReadAllocationCounts(std::size_t& numAllocations, std::size_t& numBytes);
+
+	} // namespace Benchmark
+} // namespace QDPF
+
+#endif
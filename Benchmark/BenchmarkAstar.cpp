@@ -0,0 +1,243 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_Bench: compares the hierarchical A* path finder against the naive A* on generated maps.
+//
+// For each map kind and size, the same start/target pairs are timed on:
+//   1. AStarPathFinder: Reset + ComputeNodeRoutes + ComputeGateRoutes(nodePath).
+//      Along with the mean number of popped gate vertices and temporary edges per query.
+//   2. NaiveAStarPathFinder::Compute on a plain grid graph.
+// The diff column counts the queries that the two disagree on: either reachability, or the costs
+// differ by more than the -tolerance ratio of the naive cost (the hierarchical path isn't exactly
+// optimal, and the straight lines between gate cells may be shorter than the grid moves).
+// It exits with code 1 if a path finder fails to reset.
+//
+// Usage:
+//   QDPF_Bench [-min-size 256] [-max-size 4096] [-naive-max-size 1024] [-queries 100]
+//              [-seed 2024] [-step 1] [-map all|random|maze|rooms|open] [-trace trace.json]
+//              [-implicit-edges] [-freeze] [-bidirectional] [-landmarks 0]
+//              [-contraction-hierarchy] [-node-oracle 0] [-tolerance 0.2]
+//
+// The -implicit-edges flag builds the map in the implicitIntraNodeEdges mode.
+// The -freeze flag freezes the map (QuadtreeMapX::Freeze) after the build, the build time includes it.
+// The -bidirectional flag computes the gate routes by the bidirectional A* (SetBidirectional).
+// The -landmarks flag builds given number of landmarks (QuadtreeMapX::BuildLandmarks) after the
+// build, the build time includes it.
+// The -contraction-hierarchy flag builds the contraction hierarchies
+// (QuadtreeMapX::BuildContractionHierarchy) after the build, the build time includes it. The node
+// routes are skipped then, since the gate routes search on the hierarchies without a node path.
+// The -node-oracle flag builds the node distance oracles (QuadtreeMapX::BuildNodeDistanceOracle) for
+// the components of at most given number of nodes after the build, the build time includes it.
+//
+// The -trace flag writes the trace events into given file, it requires the library to be built with
+// the cmake option QDPF_ENABLE_TRACING=ON.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "Naive/Astar.h"
+#include "Naive/GridMap.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+struct Options
+{
+	int			minSize, maxSize, naiveMaxSize;
+	int			numQueries;
+	int			seed;
+	int			step;
+	bool		implicitEdges;
+	bool		freeze;
+	bool		bidirectional;
+	int			numLandmarks;
+	bool		contractionHierarchy;
+	int			nodeOracleMaxSize;
+	double		tolerance;
+	std::string mapName;
+};
+
+// Returns false if the path finder fails to reset.
+static bool Run(const Options& options, MapKind kind, int size)
+{
+	Grid grid(size, size);
+	GenerateMap(kind, grid, options.seed);
+
+	std::vector<Query> queries;
+	GenerateQueries(grid, options.numQueries, options.seed + 1, queries);
+
+	QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+	auto					   distance = QDPF::EuclideanDistance<CostUnit>;
+	QDPF::QuadtreeMapXSettings settings{ { CostUnit, Terrain::Land } };
+
+	// ~~~~~~~~~~ hierarchical ~~~~~~~~~~~
+	QDPF::QuadtreeMapX mx(size, size, distance, terrainChecker, settings, options.step, nullptr, -1, -1,
+		QDPF::ClearanceFieldKind::TrueClearanceField, options.implicitEdges);
+
+	Stopwatch sw;
+	mx.Build();
+	if (options.freeze)
+		mx.Freeze();
+	if (options.numLandmarks > 0)
+		mx.BuildLandmarks(options.numLandmarks);
+	if (options.contractionHierarchy)
+		mx.BuildContractionHierarchy();
+	if (options.nodeOracleMaxSize > 0)
+		mx.BuildNodeDistanceOracle(options.nodeOracleMaxSize);
+	double buildMs = sw.ElapsedMs();
+
+	QDPF::AStarPathFinder pf(mx);
+	pf.SetBidirectional(options.bidirectional);
+
+	Samples		   resetUs, nodeUs, gateUs, totalUs;
+	Samples		   gatePops, tmpEdges;
+	std::vector<int> costs;
+	int				 unreachable = 0;
+
+	QDPF::NodePath nodePath;
+	QDPF::GatePath gatePath;
+
+	QDPF::PathfinderStats stats;
+
+	for (auto [x1, y1, x2, y2] : queries)
+	{
+		nodePath.clear();
+		gatePath.clear();
+
+		sw.Reset();
+		if (pf.Reset(x1, y1, x2, y2, CostUnit, Terrain::Land, &stats) != 0)
+		{
+			std::fprintf(stderr, "%s %d: AStarPathFinder::Reset failed\n", MapKindName(kind), size);
+			return false;
+		}
+		double t1 = sw.ElapsedUs();
+		int	   cost = options.contractionHierarchy ? 0 : pf.ComputeNodeRoutes(nodePath);
+		double t2 = sw.ElapsedUs();
+		if (cost != -1)
+			cost = pf.ComputeGateRoutes(gatePath, nodePath);
+		double t3 = sw.ElapsedUs();
+
+		resetUs.Add(t1), nodeUs.Add(t2 - t1), gateUs.Add(t3 - t2), totalUs.Add(t3);
+		gatePops.Add(stats.GateSearch.NumPoppedVertices), tmpEdges.Add(stats.NumTmpEdges);
+		costs.push_back(cost);
+		if (cost == -1)
+			++unreachable;
+	}
+
+	// ~~~~~~~~~~ naive ~~~~~~~~~~~
+	double	naiveBuildMs = 0;
+	Samples naiveUs;
+	int		mismatches = 0; // reachability or cost disagreements.
+
+	bool runNaive = size <= options.naiveMaxSize;
+	if (runNaive)
+	{
+		QDPF::Internal::ObstacleChecker isObstacle = [&grid](int x, int y) {
+			return grid.Get(x, y) != Terrain::Land;
+		};
+		QDPF::Naive::NaiveGridMap m(size, size, isObstacle, distance);
+
+		sw.Reset();
+		m.Build();
+		naiveBuildMs = sw.ElapsedMs();
+
+		QDPF::Naive::NaiveAStarPathFinder naive;
+		QDPF::Naive::PathCollector		  collector = [](int x, int y, int cost) {};
+
+		for (int i = 0; i < costs.size(); ++i)
+		{
+			auto [x1, y1, x2, y2] = queries[i];
+			sw.Reset();
+			int cost = naive.Compute(&m, x1, y1, x2, y2, collector);
+			naiveUs.Add(sw.ElapsedUs());
+			if ((cost == -1) != (costs[i] == -1))
+				++mismatches;
+			else if (cost > 0 && std::abs(costs[i] - cost) > options.tolerance * cost)
+				++mismatches;
+		}
+	}
+
+	std::printf("%-7s %5d %10.1f %7zu %7d %9.1f %9.1f %9.1f %9.1f %9.1f %9.0f %9.0f", MapKindName(kind),
+		size, buildMs, totalUs.Size(), unreachable, resetUs.Mean(), nodeUs.Mean(), gateUs.Mean(),
+		totalUs.Percentile(50), totalUs.Percentile(99), gatePops.Mean(), tmpEdges.Mean());
+	if (runNaive)
+	{
+		double speedup = totalUs.Mean() > 0 ? naiveUs.Mean() / totalUs.Mean() : 0;
+		std::printf(" %10.1f %9.1f %9.1f %7.1fx %5d\n", naiveBuildMs, naiveUs.Percentile(50),
+			naiveUs.Percentile(99), speedup, mismatches);
+	}
+	else
+	{
+		std::printf(" %10s %9s %9s %8s %5s\n", "-", "-", "-", "-", "-");
+	}
+	std::fflush(stdout);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.minSize = ParseIntFlag(argc, argv, "-min-size", 256);
+	options.maxSize = ParseIntFlag(argc, argv, "-max-size", 4096);
+	options.naiveMaxSize = ParseIntFlag(argc, argv, "-naive-max-size", 1024);
+	options.numQueries = ParseIntFlag(argc, argv, "-queries", 100);
+	options.seed = ParseIntFlag(argc, argv, "-seed", 2024);
+	options.step = ParseIntFlag(argc, argv, "-step", 1);
+	options.mapName = ParseStringFlag(argc, argv, "-map", "all");
+	options.implicitEdges = HasFlag(argc, argv, "-implicit-edges");
+	options.freeze = HasFlag(argc, argv, "-freeze");
+	options.bidirectional = HasFlag(argc, argv, "-bidirectional");
+	options.numLandmarks = ParseIntFlag(argc, argv, "-landmarks", 0);
+	options.contractionHierarchy = HasFlag(argc, argv, "-contraction-hierarchy");
+	options.nodeOracleMaxSize = ParseIntFlag(argc, argv, "-node-oracle", 0);
+	options.tolerance = ParseDoubleFlag(argc, argv, "-tolerance", 0.2);
+
+	// Writes trace events into a JSON array.
+	std::string tracePath = ParseStringFlag(argc, argv, "-trace", "");
+	FILE*		traceFile = nullptr;
+	if (!tracePath.empty())
+	{
+		traceFile = std::fopen(tracePath.c_str(), "w");
+		if (traceFile == nullptr)
+		{
+			std::fprintf(stderr, "failed to open %s\n", tracePath.c_str());
+			return 1;
+		}
+		std::fputs("[\n", traceFile);
+		QDPF::SetTraceSink([traceFile, first = true](const char* event) mutable {
+			std::fprintf(traceFile, first ? "%s" : ",\n%s", event);
+			first = false;
+		});
+	}
+
+	std::printf("seed=%d step=%d queries=%d implicit-edges=%d freeze=%d bidirectional=%d landmarks=%d "
+				"contraction-hierarchy=%d node-oracle=%d tolerance=%.2f (times in us unless noted)\n",
+		options.seed, options.step, options.numQueries, options.implicitEdges, options.freeze,
+		options.bidirectional, options.numLandmarks, options.contractionHierarchy,
+		options.nodeOracleMaxSize, options.tolerance);
+	std::printf("%-7s %5s %10s %7s %7s %9s %9s %9s %9s %9s %9s %9s %10s %9s %9s %8s %5s\n", "map",
+		"size", "build(ms)", "queries", "unreach", "reset", "node", "gate", "p50", "p99", "gate-pops",
+		"tmp-edges", "naive(ms)", "naive-p50", "naive-p99", "speedup", "diff");
+
+	for (auto kind : AllMapKinds)
+	{
+		if (options.mapName != "all" && options.mapName != MapKindName(kind))
+			continue;
+		for (int size = options.minSize; size <= options.maxSize; size *= 2)
+		{
+			if (!Run(options, kind, size))
+				return 1;
+		}
+	}
+
+	if (traceFile != nullptr)
+	{
+		QDPF::SetTraceSink(nullptr);
+		std::fputs("\n]\n", traceFile);
+		std::fclose(traceFile);
+	}
+	return 0;
+}
@@ -0,0 +1,187 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_BenchBuild: prints the build report of QuadtreeMapX on generated maps.
+//
+// The map is managed with all the four settings from the examples. For each map kind and size,
+// reports the wall time and allocations of each build phase, each clearance field and each
+// quadtree map, along with the resulting number of nodes, gates and graph edges.
+// Then prints the memory statistics of each quadtree map part, and the histograms of gates per node
+// and out-degree per gate cell.
+// With -implicit-edges, the maps are built in the implicitIntraNodeEdges mode.
+// With -freeze, the map is frozen (QuadtreeMapX::Freeze) after the build, so the memory statistics
+// include the snapshots. With -landmarks K, K landmarks are built (QuadtreeMapX::BuildLandmarks)
+// after the build. With -contraction-hierarchy, the contraction hierarchies are built
+// (QuadtreeMapX::BuildContractionHierarchy) after the build. With -node-oracle N, the node distance
+// oracles (QuadtreeMapX::BuildNodeDistanceOracle) are built for the components of at most N nodes.
+//
+// Usage:
+//   QDPF_BenchBuild [-min-size 256] [-max-size 1024] [-seed 2024] [-step 1] [-map all|random|...]
+//                   [-implicit-edges] [-freeze] [-landmarks 0] [-contraction-hierarchy]
+//                   [-node-oracle 0]
+
+#include <cstdio>
+#include <string>
+
+#include "BenchmarkAllocation.h"
+#include "BenchmarkUtil.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+static void PrintCost(const char* name, const QDPF::BuildCost& cost)
+{
+	std::printf("  %-36s %10.1f %12zu %14zu\n", name, cost.Milliseconds, cost.NumAllocations,
+		cost.AllocatedBytes);
+}
+
+static double MiB(std::size_t bytes)
+{
+	return bytes / 1024.0 / 1024.0;
+}
+
+// Prints a histogram on a single line, e.g. "0:12 1:30 2-3:45 4-7:2".
+static void PrintHistogram(const char* name, const QDPF::Histogram& h)
+{
+	std::printf("  %-22s mean=%.1f max=%zu |", name, h.Mean(), h.Max);
+	for (int k = 0; k < h.Buckets.size(); ++k)
+	{
+		if (h.Buckets[k] == 0)
+			continue;
+		std::size_t lo = k == 0 ? 0 : (1ull << (k - 1)), hi = k == 0 ? 0 : (1ull << k) - 1;
+		if (lo == hi)
+			std::printf(" %zu:%zu", lo, h.Buckets[k]);
+		else
+			std::printf(" %zu-%zu:%zu", lo, hi, h.Buckets[k]);
+	}
+	std::printf("\n");
+}
+
+static void PrintStats(const QDPF::QuadtreeMapX& mx)
+{
+	auto stats = mx.Stats();
+
+	std::printf("  %-36s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "memory (MiB)",
+		"tree", "node-graph", "gate-graph", "gates", "gates1", "snapshot", "landmarks", "hierarchy",
+		"node-dists", "total", "x grid");
+	char name[64];
+	for (auto& r : stats.QuadtreeMaps)
+	{
+		auto& st = r.Stats;
+		std::snprintf(name, sizeof name, "QuadtreeMap(agent=%d,terrains=%d)", r.AgentSize,
+			r.TerrainTypes);
+		std::printf("  %-36s %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f "
+					"%10.1f\n",
+			name, MiB(st.Tree.Bytes), MiB(st.NodeGraph.Bytes), MiB(st.GateGraph.Bytes),
+			MiB(st.Gates.Bytes), MiB(st.Gates1.Bytes), MiB(st.Snapshot.Bytes), MiB(st.Landmarks.Bytes),
+			MiB(st.Hierarchy.Bytes), MiB(st.NodeDistances.Bytes), MiB(st.TotalBytes()),
+			static_cast<double>(st.TotalBytes()) / stats.GridBytes);
+		PrintHistogram("gates per node", st.GatesPerNode);
+		PrintHistogram("out-degree per gate", st.OutDegreePerGateCell);
+	}
+	for (auto& r : stats.ClearanceFields)
+	{
+		std::snprintf(name, sizeof name, "ClearanceField(terrains=%d)", r.TerrainTypes);
+		std::printf("  %-36s %10.2f\n", name, MiB(r.Memory.Bytes));
+	}
+	std::printf("  %-36s %10.2f\n", "Dirties", MiB(stats.Dirties.Bytes));
+	std::printf("  %-36s %10.2f\n", "Grid", MiB(stats.GridBytes));
+	std::printf("  %-36s %10.2f (%.1fx grid)\n", "Total", MiB(stats.TotalBytes()),
+		static_cast<double>(stats.TotalBytes()) / stats.GridBytes);
+}
+
+struct Options
+{
+	int			minSize, maxSize;
+	int			seed;
+	int			step;
+	bool		implicitEdges;
+	bool		freeze;
+	int			numLandmarks;
+	bool		contractionHierarchy;
+	int			nodeOracleMaxSize;
+	std::string mapName;
+};
+
+static void Run(const Options& options, MapKind kind, int size)
+{
+	Grid grid(size, size);
+	GenerateMap(kind, grid, options.seed);
+	GenerateLakes(grid, options.seed + 1);
+
+	QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+	auto					   distance = QDPF::EuclideanDistance<CostUnit>;
+	QDPF::QuadtreeMapXSettings settings{
+		{ 1 * CostUnit, Terrain::Land },
+		{ 2 * CostUnit, Terrain::Land },
+		{ 1 * CostUnit, Terrain::Land | Terrain::Water },
+		{ 2 * CostUnit, Terrain::Water },
+	};
+	QDPF::QuadtreeMapX mx(size, size, distance, terrainChecker, settings, options.step, nullptr, -1, -1,
+		QDPF::ClearanceFieldKind::TrueClearanceField, options.implicitEdges);
+
+	QDPF::BuildReport report;
+	mx.Build(report, ReadAllocationCounts);
+	if (options.freeze)
+		mx.Freeze();
+	if (options.numLandmarks > 0)
+		mx.BuildLandmarks(options.numLandmarks);
+	if (options.contractionHierarchy)
+		mx.BuildContractionHierarchy();
+	if (options.nodeOracleMaxSize > 0)
+		mx.BuildNodeDistanceOracle(options.nodeOracleMaxSize);
+
+	std::printf("# map=%s size=%d step=%d implicit-edges=%d freeze=%d landmarks=%d "
+				"contraction-hierarchy=%d node-oracle=%d\n",
+		MapKindName(kind), size, options.step, options.implicitEdges, options.freeze,
+		options.numLandmarks, options.contractionHierarchy, options.nodeOracleMaxSize);
+	std::printf("  %-36s %10s %12s %14s\n", "step", "ms", "allocations", "bytes");
+	PrintCost("Build", report.Total);
+	for (auto& phase : report.Phases)
+		PrintCost(phase.Name.c_str(), phase.Cost);
+
+	char name[64];
+	for (auto& r : report.ClearanceFields)
+	{
+		std::snprintf(name, sizeof name, "ClearanceField(terrains=%d)", r.TerrainTypes);
+		PrintCost(name, r.Cost);
+	}
+
+	std::printf("  %-36s %10s %12s %14s %10s %10s %12s %12s\n", "quadtree map", "ms", "allocations",
+		"bytes", "nodes", "gates", "gate-edges", "node-edges");
+	for (auto& r : report.QuadtreeMaps)
+	{
+		std::snprintf(name, sizeof name, "QuadtreeMap(agent=%d,terrains=%d)", r.AgentSize,
+			r.TerrainTypes);
+		std::printf("  %-36s %10.1f %12zu %14zu %10zu %10zu %12zu %12zu\n", name, r.Cost.Milliseconds,
+			r.Cost.NumAllocations, r.Cost.AllocatedBytes, r.NumNodes, r.NumGates, r.NumGateGraphEdges,
+			r.NumNodeGraphEdges);
+	}
+
+	PrintStats(mx);
+	std::fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.minSize = ParseIntFlag(argc, argv, "-min-size", 256);
+	options.maxSize = ParseIntFlag(argc, argv, "-max-size", 1024);
+	options.seed = ParseIntFlag(argc, argv, "-seed", 2024);
+	options.step = ParseIntFlag(argc, argv, "-step", 1);
+	options.mapName = ParseStringFlag(argc, argv, "-map", "all");
+	options.implicitEdges = HasFlag(argc, argv, "-implicit-edges");
+	options.freeze = HasFlag(argc, argv, "-freeze");
+	options.numLandmarks = ParseIntFlag(argc, argv, "-landmarks", 0);
+	options.contractionHierarchy = HasFlag(argc, argv, "-contraction-hierarchy");
+	options.nodeOracleMaxSize = ParseIntFlag(argc, argv, "-node-oracle", 0);
+
+	for (auto kind : AllMapKinds)
+	{
+		if (options.mapName != "all" && options.mapName != MapKindName(kind))
+			continue;
+		for (int size = options.minSize; size <= options.maxSize; size *= 2)
+			Run(options, kind, size);
+	}
+	return 0;
+}
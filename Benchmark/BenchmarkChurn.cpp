@@ -0,0 +1,266 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_BenchChurn: replays terrain edits against a built QuadtreeMapX and measures each Compute().
+//
+// Workloads:
+//   1. cell: flips a single random cell between land and building.
+//   2. footprint: places a building footprint (4x4 ~ 16x16), or removes a previously placed one.
+//   3. wall: places a long wall (64 ~ 256 cells, 1 ~ 2 thick), or removes a previously placed one.
+//   4. explosion: clears buildings inside a disk (radius 3 ~ 10) into land.
+//
+// The map is managed with all the four settings from the examples.
+// For each workload, reports the latency of Compute(), the number of dirty cells applied by each
+// Compute(), and the number of HandleNewNode/HandleRemovedNode calls it results in.
+//
+// Usage:
+//   QDPF_BenchChurn [-size 1024] [-edits 200] [-seed 2024] [-step 1] [-map all|random|...]
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+struct Options
+{
+	int			size;
+	int			numEdits;
+	int			seed;
+	int			step;
+	std::string mapName;
+};
+
+// Rectangle of an edit that can be reverted later.
+using EditRect = QDPF::Rectangle;
+
+enum class Workload
+{
+	Cell = 0,
+	Footprint = 1,
+	Wall = 2,
+	Explosion = 3,
+};
+
+const Workload ALL_WORKLOADS[] = { Workload::Cell, Workload::Footprint, Workload::Wall,
+	Workload::Explosion };
+
+static const char* WorkloadName(Workload workload)
+{
+	switch (workload)
+	{
+		case Workload::Cell:
+			return "cell";
+		case Workload::Footprint:
+			return "footprint";
+		case Workload::Wall:
+			return "wall";
+		case Workload::Explosion:
+			return "explosion";
+	}
+	return "unknown";
+}
+
+// The four settings from the examples.
+const int AGENT_SIZES[4] = { 1 * CostUnit, 2 * CostUnit, 1 * CostUnit, 2 * CostUnit };
+const int TERRAIN_TYPES[4] = { Terrain::Land, Terrain::Land, Terrain::Land | Terrain::Water,
+	Terrain::Water };
+
+// Sums the node change counters over all managed quadtree maps.
+static void SumNodeCounters(const QDPF::QuadtreeMapX& mx, std::size_t& numNew, std::size_t& numRemoved)
+{
+	numNew = numRemoved = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		auto m = mx.Get(AGENT_SIZES[i], TERRAIN_TYPES[i]);
+		numNew += m->NumNewNodesHandled();
+		numRemoved += m->NumRemovedNodesHandled();
+	}
+}
+
+// Editor applies edits of a workload on the grid and calls mx.Update() for each changed cell.
+class Editor
+{
+public:
+	Editor(Grid& grid, QDPF::QuadtreeMapX& mx, std::uint32_t seed)
+		: grid(grid), mx(mx), rng(seed) {}
+
+	void Edit(Workload workload)
+	{
+		switch (workload)
+		{
+			case Workload::Cell:
+				EditCell();
+				break;
+			case Workload::Footprint:
+				EditRectangles(placedFootprints, [this](EditRect& r) {
+					int w = Rand(4, 16), h = Rand(4, 16);
+					int x1 = Rand(0, grid.W() - w), y1 = Rand(0, grid.H() - h);
+					r = { x1, y1, x1 + w - 1, y1 + h - 1 };
+				});
+				break;
+			case Workload::Wall:
+				EditRectangles(placedWalls, [this](EditRect& r) {
+					int length = Rand(64, 256), thick = Rand(1, 2);
+					int x1 = Rand(0, grid.W() - 1), y1 = Rand(0, grid.H() - 1);
+					if (Rand(0, 1))
+						r = { x1, y1, x1 + length - 1, y1 + thick - 1 };
+					else
+						r = { x1, y1, x1 + thick - 1, y1 + length - 1 };
+				});
+				break;
+			case Workload::Explosion:
+				EditExplosion();
+				break;
+		}
+	}
+
+private:
+	Grid&				grid;
+	QDPF::QuadtreeMapX& mx;
+	std::mt19937		rng;
+
+	// placed rectangles, they are removed in FIFO order.
+	std::deque<EditRect> placedFootprints, placedWalls;
+
+	int Rand(int a, int b) { return std::uniform_int_distribution<int>(a, std::max(a, b))(rng); }
+
+	void Set(int x, int y, int v)
+	{
+		if (!(x >= 0 && x < grid.W() && y >= 0 && y < grid.H()))
+			return;
+		if (grid.Get(x, y) == v)
+			return;
+		grid.Set(x, y, v);
+		mx.Update(x, y);
+	}
+
+	void SetRect(const EditRect& r, int v)
+	{
+		for (int y = r.y1; y <= r.y2; ++y)
+		{
+			for (int x = r.x1; x <= r.x2; ++x)
+				Set(x, y, v);
+		}
+	}
+
+	void EditCell()
+	{
+		int x = Rand(0, grid.W() - 1), y = Rand(0, grid.H() - 1);
+		Set(x, y, grid.Get(x, y) == Terrain::Building ? Terrain::Land : Terrain::Building);
+	}
+
+	// Places a new rectangle of buildings, or removes the oldest placed one (half of the chance
+	// once there're enough placed).
+	template <typename Generator>
+	void EditRectangles(std::deque<EditRect>& placed, Generator generate)
+	{
+		if (placed.size() >= 8 && Rand(0, 1))
+		{
+			SetRect(placed.front(), Terrain::Land);
+			placed.pop_front();
+			return;
+		}
+		EditRect r;
+		generate(r);
+		SetRect(r, Terrain::Building);
+		placed.push_back(r);
+	}
+
+	void EditExplosion()
+	{
+		int r = Rand(3, 10);
+		int cx = Rand(0, grid.W() - 1), cy = Rand(0, grid.H() - 1);
+		for (int y = cy - r; y <= cy + r; ++y)
+		{
+			for (int x = cx - r; x <= cx + r; ++x)
+			{
+				if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= r * r && grid.Is(x, y, Terrain::Building))
+					Set(x, y, Terrain::Land);
+			}
+		}
+	}
+};
+
+static void Run(const Options& options, MapKind kind)
+{
+	int	 size = options.size;
+	Grid grid(size, size);
+	GenerateMap(kind, grid, options.seed);
+
+	// Paints some lakes, so that all the four settings are relevant.
+	GenerateLakes(grid, options.seed + 1);
+
+	QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+	auto					   distance = QDPF::EuclideanDistance<CostUnit>;
+	QDPF::QuadtreeMapXSettings settings{
+		{ AGENT_SIZES[0], TERRAIN_TYPES[0] },
+		{ AGENT_SIZES[1], TERRAIN_TYPES[1] },
+		{ AGENT_SIZES[2], TERRAIN_TYPES[2] },
+		{ AGENT_SIZES[3], TERRAIN_TYPES[3] },
+	};
+	QDPF::QuadtreeMapX mx(size, size, distance, terrainChecker, settings, options.step);
+
+	Stopwatch sw;
+	mx.Build();
+	std::printf("# map=%s size=%d build=%.1fms\n", MapKindName(kind), size, sw.ElapsedMs());
+
+	Editor editor(grid, mx, options.seed + 2);
+
+	for (auto workload : ALL_WORKLOADS)
+	{
+		Samples computeUs, dirties, newNodes, removedNodes;
+
+		for (int i = 0; i < options.numEdits; ++i)
+		{
+			editor.Edit(workload);
+
+			std::size_t new1, removed1, new2, removed2;
+			SumNodeCounters(mx, new1, removed1);
+
+			sw.Reset();
+			mx.Compute();
+			computeUs.Add(sw.ElapsedUs());
+
+			dirties.Add(mx.NumDirtyCells());
+			SumNodeCounters(mx, new2, removed2);
+			newNodes.Add(new2 - new1);
+			removedNodes.Add(removed2 - removed1);
+		}
+
+		std::printf("%-7s %-10s %6zu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+			MapKindName(kind), WorkloadName(workload), computeUs.Size(), computeUs.Mean(),
+			computeUs.Percentile(50), computeUs.Percentile(99), computeUs.Max(), dirties.Mean(),
+			dirties.Max(), newNodes.Mean(), removedNodes.Mean());
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.size = ParseIntFlag(argc, argv, "-size", 1024);
+	options.numEdits = ParseIntFlag(argc, argv, "-edits", 200);
+	options.seed = ParseIntFlag(argc, argv, "-seed", 2024);
+	options.step = ParseIntFlag(argc, argv, "-step", 1);
+	options.mapName = ParseStringFlag(argc, argv, "-map", "all");
+
+	std::printf("size=%d seed=%d step=%d edits=%d (times in us)\n", options.size, options.seed,
+		options.step, options.numEdits);
+	std::printf("%-7s %-10s %6s %9s %9s %9s %9s %9s %9s %9s %9s\n", "map", "workload", "edits", "mean",
+		"p50", "p99", "max", "dirty", "dirty-max", "new", "removed");
+
+	for (auto kind : AllMapKinds)
+	{
+		if (options.mapName != "all" && options.mapName != MapKindName(kind))
+			continue;
+		Run(options, kind);
+	}
+	return 0;
+}
@@ -0,0 +1,240 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_BenchFlowfield: measures the flow-field path finder stage by stage.
+//
+// Sweeps the query range size (8x8 ... 512x512) and the distance from the query range's center to
+// the target. For each combination, random trials are timed on:
+//   1. FlowFieldPathFinder: Reset, ComputeNodeFlowField, ComputeGateFlowField(nodeFlowField)
+//      and ComputeFinalFlowField.
+//   2. NaiveFlowFieldPathFinder::Compute on a plain grid graph.
+// The diff column counts the cells of the query ranges (summed over the trials) where the final
+// flow field disagrees with the naive one: on reachability, or on the cost by more than -tolerance
+// of the naive cost.
+// It exits with code 1 if the path finder fails to reset.
+//
+// Usage:
+//   QDPF_BenchFlowfield [-size 1024] [-trials 20] [-seed 2024] [-step 1] [-map all|random|...]
+//                       [-min-qrange 8] [-max-qrange 512] [-no-naive] [-tolerance 0.2]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "Naive/Flowfield.h"
+#include "Naive/GridMap.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+struct Options
+{
+	int			size;
+	int			numTrials;
+	int			seed;
+	int			step;
+	int			minQrange, maxQrange;
+	bool		naive;
+	double		tolerance;
+	std::string mapName;
+};
+
+// Distances (in cells) from the query range's center to the target.
+// Distance 0 means the target is a random cell inside the query range.
+const int TARGET_DISTANCES[] = { 0, 32, 128, 512 };
+
+// Picks a target cell on land at the given distance from the query range's center.
+// Returns false if not found after some attempts.
+static bool PickTarget(const Grid& grid, std::mt19937& rng, const QDPF::Rectangle& qrange, int d,
+	int& x, int& y)
+{
+	const double						   pi = std::acos(-1.0);
+	std::uniform_real_distribution<double> angle(0, 2 * pi);
+	std::uniform_int_distribution<int>	   rx(qrange.x1, qrange.x2), ry(qrange.y1, qrange.y2);
+
+	int cx = qrange.x1 + (qrange.x2 - qrange.x1) / 2, cy = qrange.y1 + (qrange.y2 - qrange.y1) / 2;
+
+	for (int attempts = 0; attempts < 100; ++attempts)
+	{
+		if (d == 0)
+		{
+			x = rx(rng), y = ry(rng);
+		}
+		else
+		{
+			double a = angle(rng);
+			x = cx + static_cast<int>(std::round(d * std::cos(a)));
+			y = cy + static_cast<int>(std::round(d * std::sin(a)));
+		}
+		if (grid.Is(x, y, Terrain::Land))
+			return true;
+	}
+	return false;
+}
+
+// Returns the number of cells in the query range where the flow field disagrees with the naive one.
+static int CountMismatches(const QDPF::Rectangle& qrange, const QDPF::FinalFlowField& field,
+	const QDPF::FinalFlowField& naiveField, double tolerance)
+{
+	int mismatches = 0;
+	for (int x = qrange.x1; x <= qrange.x2; ++x)
+	{
+		for (int y = qrange.y1; y <= qrange.y2; ++y)
+		{
+			int cost = field.Cost({ x, y }), naiveCost = naiveField.Cost({ x, y });
+			if ((cost == QDPF::inf) != (naiveCost == QDPF::inf))
+				++mismatches;
+			else if (naiveCost != QDPF::inf && naiveCost > 0
+				&& std::abs(cost - naiveCost) > tolerance * naiveCost)
+				++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+static void PrintStage(const Samples& samples)
+{
+	std::printf(" %8.1f %8.1f", samples.Percentile(50), samples.Percentile(99));
+}
+
+// Returns false if the path finder fails to reset.
+static bool Run(const Options& options, MapKind kind, QDPF::QuadtreeMapX& mx,
+	const QDPF::Naive::NaiveGridMap* naiveMap, const Grid& grid)
+{
+	QDPF::FlowFieldPathFinder			pf(mx);
+	QDPF::Naive::NaiveFlowFieldPathFinder naive;
+
+	std::mt19937 rng(options.seed + 1);
+
+	QDPF::NodeFlowField  nodeFlowField;
+	QDPF::GateFlowField  gateFlowField;
+	QDPF::FinalFlowField finalFlowField, naiveFlowField;
+
+	for (int q = options.minQrange; q <= options.maxQrange && q <= options.size; q *= 2)
+	{
+		for (auto d : TARGET_DISTANCES)
+		{
+			if (d >= options.size)
+				continue;
+
+			Samples resetUs, nodeUs, gateUs, finalUs, totalUs, naiveUs;
+			Samples numNodes, numGates, numCells;
+			int		mismatches = 0;
+
+			std::uniform_int_distribution<int> rx(0, options.size - q);
+
+			for (int trial = 0; trial < options.numTrials; ++trial)
+			{
+				int				x1 = rx(rng), y1 = rx(rng);
+				QDPF::Rectangle qrange{ x1, y1, x1 + q - 1, y1 + q - 1 };
+				int				x2, y2;
+				if (!PickTarget(grid, rng, qrange, d, x2, y2))
+					continue;
+
+				Stopwatch sw;
+				if (pf.Reset(x2, y2, qrange, CostUnit, Terrain::Land) != 0)
+				{
+					std::fprintf(stderr, "%s qrange=%d dist=%d: FlowFieldPathFinder::Reset failed\n",
+						MapKindName(kind), q, d);
+					return false;
+				}
+				double t1 = sw.ElapsedUs();
+				(void)pf.ComputeNodeFlowField(nodeFlowField);
+				double t2 = sw.ElapsedUs();
+				(void)pf.ComputeGateFlowField(gateFlowField, nodeFlowField);
+				double t3 = sw.ElapsedUs();
+				(void)pf.ComputeFinalFlowField(finalFlowField, gateFlowField);
+				double t4 = sw.ElapsedUs();
+
+				resetUs.Add(t1), nodeUs.Add(t2 - t1), gateUs.Add(t3 - t2), finalUs.Add(t4 - t3);
+				totalUs.Add(t4);
+				numNodes.Add(nodeFlowField.Size());
+				numGates.Add(gateFlowField.Size());
+				numCells.Add(finalFlowField.Size());
+
+				if (naiveMap != nullptr)
+				{
+					naiveFlowField.Clear();
+					sw.Reset();
+					naive.Compute(naiveMap, x2, y2, qrange, naiveFlowField);
+					naiveUs.Add(sw.ElapsedUs());
+					mismatches += CountMismatches(qrange, finalFlowField, naiveFlowField, options.tolerance);
+				}
+			}
+
+			std::printf("%-7s %6d %5d %6zu", MapKindName(kind), q, d, totalUs.Size());
+			PrintStage(resetUs), PrintStage(nodeUs), PrintStage(gateUs), PrintStage(finalUs);
+			PrintStage(totalUs);
+			std::printf(" %7.0f %7.0f %8.0f", numNodes.Mean(), numGates.Mean(), numCells.Mean());
+			if (naiveMap != nullptr)
+			{
+				PrintStage(naiveUs);
+				double speedup = totalUs.Mean() > 0 ? naiveUs.Mean() / totalUs.Mean() : 0;
+				std::printf(" %7.1fx %6d\n", speedup, mismatches);
+			}
+			else
+			{
+				std::printf(" %8s %8s %8s %6s\n", "-", "-", "-", "-");
+			}
+			std::fflush(stdout);
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.size = ParseIntFlag(argc, argv, "-size", 1024);
+	options.numTrials = ParseIntFlag(argc, argv, "-trials", 20);
+	options.seed = ParseIntFlag(argc, argv, "-seed", 2024);
+	options.step = ParseIntFlag(argc, argv, "-step", 1);
+	options.minQrange = ParseIntFlag(argc, argv, "-min-qrange", 8);
+	options.maxQrange = ParseIntFlag(argc, argv, "-max-qrange", 512);
+	options.naive = !HasFlag(argc, argv, "-no-naive");
+	options.tolerance = ParseDoubleFlag(argc, argv, "-tolerance", 0.2);
+	options.mapName = ParseStringFlag(argc, argv, "-map", "all");
+
+	std::printf("size=%d seed=%d step=%d trials=%d (times in us, p50 and p99 for each stage)\n",
+		options.size, options.seed, options.step, options.numTrials);
+	std::printf("%-7s %6s %5s %6s %17s %17s %17s %17s %17s %7s %7s %8s %17s %8s %6s\n", "map",
+		"qrange", "dist", "trials", "reset", "node", "gate", "final", "total", "nodes", "gates", "cells",
+		"naive", "speedup", "diff");
+
+	auto distance = QDPF::EuclideanDistance<CostUnit>;
+
+	for (auto kind : AllMapKinds)
+	{
+		if (options.mapName != "all" && options.mapName != MapKindName(kind))
+			continue;
+
+		Grid grid(options.size, options.size);
+		GenerateMap(kind, grid, options.seed);
+
+		QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+		QDPF::QuadtreeMapXSettings settings{ { CostUnit, Terrain::Land } };
+		QDPF::QuadtreeMapX		   mx(options.size, options.size, distance, terrainChecker, settings,
+					  options.step);
+		mx.Build();
+
+		QDPF::Internal::ObstacleChecker isObstacle = [&grid](int x, int y) {
+			return grid.Get(x, y) != Terrain::Land;
+		};
+		std::unique_ptr<QDPF::Naive::NaiveGridMap> naiveMap = nullptr;
+		if (options.naive)
+		{
+			naiveMap = std::make_unique<QDPF::Naive::NaiveGridMap>(options.size, options.size, isObstacle,
+				distance);
+			naiveMap->Build();
+		}
+
+		if (!Run(options, kind, mx, naiveMap.get(), grid))
+			return 1;
+	}
+	return 0;
+}
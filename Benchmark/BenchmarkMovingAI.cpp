@@ -0,0 +1,81 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "BenchmarkMovingAI.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace QDPF
+{
+	namespace Benchmark
+	{
+
+		static int MovingAITerrain(char c)
+		{
+			switch (c)
+			{
+				case '.':
+				case 'G':
+				case 'S': // swamp
+					return Terrain::Land;
+				case 'W':
+					return Terrain::Water;
+				default: // '@', 'O', 'T'
+					return Terrain::Building;
+			}
+		}
+
+		bool LoadMovingAIMap(const std::string& path, Grid& grid)
+		{
+			std::ifstream in(path);
+			if (!in)
+				return false;
+
+			// header: "type octile", "height H", "width W", "map".
+			int			w = -1, h = -1;
+			std::string key;
+			while (in >> key && key != "map")
+			{
+				if (key == "height")
+					in >> h;
+				else if (key == "width")
+					in >> w;
+				else if (key == "type")
+					in >> key;
+			}
+			if (key != "map" || w <= 0 || h <= 0)
+				return false;
+
+			grid = Grid(w, h, Terrain::Building);
+			std::string line;
+			for (int y = 0; y < h && in >> line; ++y)
+			{
+				for (int x = 0; x < w && x < line.size(); ++x)
+					grid.Set(x, y, MovingAITerrain(line[x]));
+			}
+			return true;
+		}
+
+		bool LoadMovingAIScenarios(const std::string& path, std::vector<MovingAIScenario>& scenarios)
+		{
+			std::ifstream in(path);
+			if (!in)
+				return false;
+
+			std::string line;
+			while (std::getline(in, line))
+			{
+				// skips the "version x" line and blank lines.
+				if (line.empty() || line.rfind("version", 0) == 0)
+					continue;
+				std::istringstream ss(line);
+				MovingAIScenario   s;
+				if (ss >> s.bucket >> s.map >> s.w >> s.h >> s.x1 >> s.y1 >> s.x2 >> s.y2 >> s.optimal)
+					scenarios.push_back(s);
+			}
+			return true;
+		}
+
+	} // namespace Benchmark
+} // namespace QDPF
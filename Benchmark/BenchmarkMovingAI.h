@@ -0,0 +1,43 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// Loaders of the MovingAI grid benchmark formats (https://movingai.com/benchmarks/formats.html).
+// **NOTE**: This file is NOT required to use quadtree-pathfinding.
+
+#ifndef QDPF_BENCHMARK_MOVINGAI_HPP
+#define QDPF_BENCHMARK_MOVINGAI_HPP
+
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+
+namespace QDPF
+{
+	namespace Benchmark
+	{
+
+		// Loads a MovingAI .map file into grid, the x is the column and the y is the row.
+		// Terrain characters are mapped to:
+		//   '.', 'G', 'S' => Land;  'W' => Water;  '@', 'O', 'T' and others => Building.
+		// Returns false if the file can't be opened or its header is malformed.
+		bool LoadMovingAIMap(const std::string& path, Grid& grid);
+
+		// A scenario (a line) of a MovingAI .scen file.
+		struct MovingAIScenario
+		{
+			int			bucket;
+			std::string map; // map path, as written in the scenario file.
+			int			w, h;
+			int			x1, y1, x2, y2;
+			double		optimal; // optimal length, the diagonal costs sqrt(2).
+		};
+
+		// Loads all scenarios of a MovingAI .scen file (version 1).
+		// Returns false if the file can't be opened.
+		bool LoadMovingAIScenarios(const std::string& path, std::vector<MovingAIScenario>& scenarios);
+
+	} // namespace Benchmark
+} // namespace QDPF
+
+#endif
@@ -0,0 +1,223 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_BenchQuality: the trade-off between path quality and speed for gate picking settings.
+//
+// For each map kind, the optimal costs of random queries are computed once by the naive A*.
+// Then for each setting of { step or step function, maxNodeWidth }, the same queries are run on
+// AStarPathFinder in two modes:
+//   1. gate: ComputeGateRoutes without a node path.
+//   2. node+gate: ComputeNodeRoutes, and then ComputeGateRoutes on the node path.
+//
+// For each mode, reports the distribution of the suboptimality ratio (cost / optimal cost) and the
+// speedup against the naive A*. The ratio can be a bit less than 1, since the straight lines
+// between gate cells are measured by the euclidean distance, while the naive A* walks on 8
+// directions.
+// Exits with code 1 if the path finder fails to reset.
+//
+// Usage:
+//   QDPF_BenchQuality [-size 256] [-queries 1000] [-seed 2024] [-map all|random|...]
+//                     [-max-node-widths -1,64,16]
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "Naive/Astar.h"
+#include "Naive/GridMap.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+struct Options
+{
+	int				 size;
+	int				 numQueries;
+	int				 seed;
+	std::string		 mapName;
+	std::vector<int> maxNodeWidths;
+};
+
+// A gate picking setting: a constant step, or a step function.
+struct StepSetting
+{
+	const char*		   name;
+	int				   step;
+	QDPF::StepFunction stepf;
+};
+
+const StepSetting STEP_SETTINGS[] = {
+	{ "step=1", 1, nullptr },
+	{ "step=2", 2, nullptr },
+	{ "step=4", 4, nullptr },
+	{ "step=8", 8, nullptr },
+	{ "len/2+1", 1, [](int length) { return length / 2 + 1; } },
+	{ "len/4+1", 1, [](int length) { return length / 4 + 1; } },
+	{ "len/8+1", 1, [](int length) { return length / 8 + 1; } },
+};
+
+// Result of a mode on a setting.
+struct ModeResult
+{
+	Samples ratios, us;
+	int		mismatches = 0; // reachability disagreements with the naive A*.
+};
+
+static void AddResult(ModeResult& r, int cost, int optimal, double us)
+{
+	r.us.Add(us);
+	if ((cost == -1) != (optimal == -1))
+		++r.mismatches;
+	else if (cost != -1 && optimal > 0)
+		r.ratios.Add(static_cast<double>(cost) / optimal);
+}
+
+static void PrintResult(const ModeResult& r, double naiveUs)
+{
+	double speedup = r.us.Mean() > 0 ? naiveUs / r.us.Mean() : 0;
+	std::printf(" | %6.3f %6.3f %6.3f %6.3f %6.3f %7.1fx %4d", r.ratios.Mean(), r.ratios.Percentile(50),
+		r.ratios.Percentile(90), r.ratios.Percentile(99), r.ratios.Max(), speedup, r.mismatches);
+}
+
+// Returns false if the path finder fails to reset.
+static bool Run(const Options& options, MapKind kind)
+{
+	int	 size = options.size;
+	Grid grid(size, size);
+	GenerateMap(kind, grid, options.seed);
+
+	std::vector<Query> queries;
+	GenerateQueries(grid, options.numQueries, options.seed + 1, queries);
+
+	auto distance = QDPF::EuclideanDistance<CostUnit>;
+
+	// ~~~~~~~~~~ optimal costs by the naive A* ~~~~~~~~~~~
+	QDPF::Internal::ObstacleChecker isObstacle = [&grid](int x, int y) {
+		return grid.Get(x, y) != Terrain::Land;
+	};
+	QDPF::Naive::NaiveGridMap m(size, size, isObstacle, distance);
+	m.Build();
+
+	QDPF::Naive::NaiveAStarPathFinder naive;
+	QDPF::Naive::PathCollector		  collector = [](int x, int y, int cost) {};
+
+	Stopwatch		 sw;
+	Samples			 naiveUs;
+	std::vector<int> optimal;
+	for (auto [x1, y1, x2, y2] : queries)
+	{
+		sw.Reset();
+		optimal.push_back(naive.Compute(&m, x1, y1, x2, y2, collector));
+		naiveUs.Add(sw.ElapsedUs());
+	}
+
+	// ~~~~~~~~~~ hierarchical, for each setting ~~~~~~~~~~~
+	QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+	QDPF::QuadtreeMapXSettings settings{ { CostUnit, Terrain::Land } };
+
+	for (int maxNodeWidth : options.maxNodeWidths)
+	{
+		for (auto& setting : STEP_SETTINGS)
+		{
+			QDPF::QuadtreeMapX mx(size, size, distance, terrainChecker, settings, setting.step,
+				setting.stepf, maxNodeWidth, maxNodeWidth);
+			sw.Reset();
+			mx.Build();
+			double buildMs = sw.ElapsedMs();
+
+			QDPF::AStarPathFinder pf(mx);
+			QDPF::NodePath		  nodePath;
+			QDPF::GatePath		  gatePath;
+			ModeResult			  gate, nodeGate;
+
+			for (int i = 0; i < queries.size(); ++i)
+			{
+				auto [x1, y1, x2, y2] = queries[i];
+
+				// gate only.
+				gatePath.clear();
+				sw.Reset();
+				if (pf.Reset(x1, y1, x2, y2, CostUnit, Terrain::Land) != 0)
+				{
+					std::fprintf(stderr, "%s %s maxw=%d gate (%d,%d)->(%d,%d): AStarPathFinder::Reset failed\n",
+						MapKindName(kind), setting.name, maxNodeWidth, x1, y1, x2, y2);
+					return false;
+				}
+				int cost = pf.ComputeGateRoutes(gatePath);
+				AddResult(gate, cost, optimal[i], sw.ElapsedUs());
+
+				// node path + gate.
+				nodePath.clear();
+				gatePath.clear();
+				sw.Reset();
+				if (pf.Reset(x1, y1, x2, y2, CostUnit, Terrain::Land) != 0)
+				{
+					std::fprintf(stderr,
+						"%s %s maxw=%d node+gate (%d,%d)->(%d,%d): AStarPathFinder::Reset failed\n",
+						MapKindName(kind), setting.name, maxNodeWidth, x1, y1, x2, y2);
+					return false;
+				}
+				cost = pf.ComputeNodeRoutes(nodePath);
+				if (cost != -1)
+					cost = pf.ComputeGateRoutes(gatePath, nodePath);
+				AddResult(nodeGate, cost, optimal[i], sw.ElapsedUs());
+			}
+
+			auto m = mx.Get(CostUnit, Terrain::Land);
+			std::printf("%-7s %8s %5d %9.1f %8zu", MapKindName(kind), setting.name, maxNodeWidth, buildMs,
+				m->NumGates());
+			PrintResult(gate, naiveUs.Mean());
+			PrintResult(nodeGate, naiveUs.Mean());
+			std::printf("\n");
+			std::fflush(stdout);
+		}
+	}
+	return true;
+}
+
+// Parses a comma separated list of integers, e.g. "-1,64,16".
+static std::vector<int> ParseIntList(const std::string& s)
+{
+	std::vector<int>  list;
+	std::stringstream ss(s);
+	std::string		  item;
+	while (std::getline(ss, item, ','))
+	{
+		if (!item.empty())
+			list.push_back(std::atoi(item.c_str()));
+	}
+	return list;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.size = ParseIntFlag(argc, argv, "-size", 256);
+	options.numQueries = ParseIntFlag(argc, argv, "-queries", 1000);
+	options.seed = ParseIntFlag(argc, argv, "-seed", 2024);
+	options.mapName = ParseStringFlag(argc, argv, "-map", "all");
+	options.maxNodeWidths = ParseIntList(ParseStringFlag(argc, argv, "-max-node-widths", "-1,64,16"));
+
+	std::printf("size=%d seed=%d queries=%d (ratio = cost / optimal cost)\n", options.size,
+		options.seed, options.numQueries);
+	std::printf("%-7s %8s %5s %9s %8s | %-46s | %-46s\n", "", "", "", "", "", "gate",
+		"node+gate");
+	std::printf("%-7s %8s %5s %9s %8s", "map", "setting", "maxw", "build(ms)", "gates");
+	for (int i = 0; i < 2; ++i)
+		std::printf(" | %6s %6s %6s %6s %6s %8s %4s", "mean", "p50", "p90", "p99", "max", "speedup",
+			"diff");
+	std::printf("\n");
+
+	for (auto kind : AllMapKinds)
+	{
+		if (options.mapName != "all" && options.mapName != MapKindName(kind))
+			continue;
+		if (!Run(options, kind))
+			return 1;
+	}
+	return 0;
+}
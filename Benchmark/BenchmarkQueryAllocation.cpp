@@ -0,0 +1,251 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_BenchAllocs: counts the heap allocations and allocated bytes of each query, stage by stage.
+//
+// The global operator new is replaced (see BenchmarkAllocation.cpp), the counters are read before
+// and after each stage of:
+//   1. AStarPathFinder: Reset + ComputeGateRoutes, and Reset + ComputeNodeRoutes +
+//      ComputeGateRoutes(nodePath).
+//   2. FlowFieldPathFinder: Reset + ComputeNodeFlowField + ComputeGateFlowField(nodeFlowField) +
+//      ComputeFinalFlowField.
+//
+// The output containers are reused across queries (as a game would do), and a few warm-up queries
+// are run ahead, so the numbers are the steady state allocations of the library.
+//
+// With -max-allocs N, exits with code 1 if the mean allocations per query of any pipeline exceeds
+// N, to guard against regressions. -max-allocs-astar and -max-allocs-flowfield override it for
+// the A* pipelines and the flow-field pipeline: the flow fields are hash maps, filling them
+// allocates per entry, so the flow-field pipeline needs a larger limit, growing with -qrange.
+// It exits with code 1 as well if a path finder fails to reset.
+//
+// Usage:
+//   QDPF_BenchAllocs [-size 256] [-queries 1000] [-seed 2024] [-step 1] [-qrange 64]
+//                    [-map all|random|...] [-max-allocs -1] [-max-allocs-astar N]
+//                    [-max-allocs-flowfield N]
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchmarkAllocation.h"
+#include "BenchmarkUtil.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+struct Options
+{
+	int			size;
+	int			numQueries;
+	int			seed;
+	int			step;
+	int			qrange;
+	int			maxAllocsAStar;
+	int			maxAllocsFlowField;
+	std::string mapName;
+};
+
+// Number of queries run before counting.
+const int NUM_WARMUP_QUERIES = 10;
+
+// AllocationMeter collects the allocations of a stage, by Begin() and End().
+class AllocationMeter
+{
+public:
+	void Begin() { ReadAllocationCounts(allocs, bytes); }
+	void End()
+	{
+		std::size_t allocs1, bytes1;
+		ReadAllocationCounts(allocs1, bytes1);
+		numAllocations.Add(allocs1 - allocs);
+		numBytes.Add(bytes1 - bytes);
+	}
+
+	Samples numAllocations, numBytes;
+
+private:
+	std::size_t allocs = 0, bytes = 0;
+};
+
+static void PrintMeter(const char* pipeline, const char* stage, const AllocationMeter& m)
+{
+	std::printf("%-10s %-18s %10.1f %8.0f %8.0f %12.0f %10.0f\n", pipeline, stage,
+		m.numAllocations.Mean(), m.numAllocations.Percentile(50), m.numAllocations.Max(),
+		m.numBytes.Mean(), m.numBytes.Max());
+}
+
+// Returns false if the mean allocations of meter m exceeds maxAllocs, which is from the flag
+// named flag.
+static bool Check(MapKind kind, const char* pipeline, const AllocationMeter& m, int maxAllocs,
+	const char* flag)
+{
+	if (maxAllocs < 0 || m.numAllocations.Mean() <= maxAllocs)
+		return true;
+	std::fprintf(stderr, "%s %s: %.1f allocations per query exceeds %s %d\n", MapKindName(kind),
+		pipeline, m.numAllocations.Mean(), flag, maxAllocs);
+	return false;
+}
+
+static bool RunAStar(const Options& options, MapKind kind, QDPF::QuadtreeMapX& mx,
+	const std::vector<Query>& queries)
+{
+	QDPF::AStarPathFinder pf(mx);
+	QDPF::NodePath		  nodePath;
+	QDPF::GatePath		  gatePath;
+
+	AllocationMeter reset1, gate1, total1;			// Reset + ComputeGateRoutes
+	AllocationMeter reset2, node2, gate2, total2;	// Reset + ComputeNodeRoutes + ComputeGateRoutes
+
+	for (int i = 0; i < queries.size(); ++i)
+	{
+		auto [x1, y1, x2, y2] = queries[i];
+		bool warmup = i < NUM_WARMUP_QUERIES;
+
+		// gate only.
+		gatePath.clear();
+		total1.Begin(), reset1.Begin();
+		if (pf.Reset(x1, y1, x2, y2, CostUnit, Terrain::Land) != 0)
+		{
+			std::fprintf(stderr, "%s astar (%d,%d)->(%d,%d): AStarPathFinder::Reset failed\n",
+				MapKindName(kind), x1, y1, x2, y2);
+			return false;
+		}
+		reset1.End(), gate1.Begin();
+		(void)pf.ComputeGateRoutes(gatePath);
+		gate1.End(), total1.End();
+
+		// node path + gate.
+		nodePath.clear();
+		gatePath.clear();
+		total2.Begin(), reset2.Begin();
+		if (pf.Reset(x1, y1, x2, y2, CostUnit, Terrain::Land) != 0)
+		{
+			std::fprintf(stderr, "%s astar+node (%d,%d)->(%d,%d): AStarPathFinder::Reset failed\n",
+				MapKindName(kind), x1, y1, x2, y2);
+			return false;
+		}
+		reset2.End(), node2.Begin();
+		(void)pf.ComputeNodeRoutes(nodePath);
+		node2.End(), gate2.Begin();
+		(void)pf.ComputeGateRoutes(gatePath, nodePath);
+		gate2.End(), total2.End();
+
+		if (warmup)
+		{
+			for (auto m : { &reset1, &gate1, &total1, &reset2, &node2, &gate2, &total2 })
+				*m = AllocationMeter();
+		}
+	}
+
+	PrintMeter("astar", "Reset", reset1);
+	PrintMeter("astar", "GateRoutes", gate1);
+	PrintMeter("astar", "total", total1);
+	PrintMeter("astar+node", "Reset", reset2);
+	PrintMeter("astar+node", "NodeRoutes", node2);
+	PrintMeter("astar+node", "GateRoutes", gate2);
+	PrintMeter("astar+node", "total", total2);
+	bool ok1 = Check(kind, "astar", total1, options.maxAllocsAStar, "-max-allocs-astar");
+	bool ok2 = Check(kind, "astar+node", total2, options.maxAllocsAStar, "-max-allocs-astar");
+	return ok1 && ok2;
+}
+
+static bool RunFlowField(const Options& options, MapKind kind, QDPF::QuadtreeMapX& mx,
+	const std::vector<Query>& queries)
+{
+	QDPF::FlowFieldPathFinder pf(mx);
+	QDPF::NodeFlowField		  nodeFlowField;
+	QDPF::GateFlowField		  gateFlowField;
+	QDPF::FinalFlowField	  finalFlowField;
+
+	AllocationMeter reset, node, gate, finalField, total;
+
+	int q = std::min(options.qrange, options.size);
+	for (int i = 0; i < queries.size(); ++i)
+	{
+		// query range: a q x q square around the start, clipped by the map bounds.
+		auto [x1, y1, x2, y2] = queries[i];
+		int				rx = std::min(std::max(0, x1 - q / 2), options.size - q);
+		int				ry = std::min(std::max(0, y1 - q / 2), options.size - q);
+		QDPF::Rectangle qrange{ rx, ry, rx + q - 1, ry + q - 1 };
+
+		total.Begin(), reset.Begin();
+		if (pf.Reset(x2, y2, qrange, CostUnit, Terrain::Land) != 0)
+		{
+			std::fprintf(stderr,
+				"%s flowfield (%d,%d) qrange (%d,%d)-(%d,%d): FlowFieldPathFinder::Reset failed\n",
+				MapKindName(kind), x2, y2, qrange.x1, qrange.y1, qrange.x2, qrange.y2);
+			return false;
+		}
+		reset.End(), node.Begin();
+		(void)pf.ComputeNodeFlowField(nodeFlowField);
+		node.End(), gate.Begin();
+		(void)pf.ComputeGateFlowField(gateFlowField, nodeFlowField);
+		gate.End(), finalField.Begin();
+		(void)pf.ComputeFinalFlowField(finalFlowField, gateFlowField);
+		finalField.End(), total.End();
+
+		if (i < NUM_WARMUP_QUERIES)
+		{
+			for (auto m : { &reset, &node, &gate, &finalField, &total })
+				*m = AllocationMeter();
+		}
+	}
+
+	PrintMeter("flowfield", "Reset", reset);
+	PrintMeter("flowfield", "NodeFlowField", node);
+	PrintMeter("flowfield", "GateFlowField", gate);
+	PrintMeter("flowfield", "FinalFlowField", finalField);
+	PrintMeter("flowfield", "total", total);
+	return Check(kind, "flowfield", total, options.maxAllocsFlowField, "-max-allocs-flowfield");
+}
+
+static bool Run(const Options& options, MapKind kind)
+{
+	Grid grid(options.size, options.size);
+	GenerateMap(kind, grid, options.seed);
+
+	std::vector<Query> queries;
+	GenerateQueries(grid, options.numQueries + NUM_WARMUP_QUERIES, options.seed + 1, queries);
+
+	QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+	QDPF::QuadtreeMapXSettings settings{ { CostUnit, Terrain::Land } };
+	QDPF::QuadtreeMapX		   mx(options.size, options.size, QDPF::EuclideanDistance<CostUnit>,
+				  terrainChecker, settings, options.step);
+	mx.Build();
+
+	std::printf("~~~~~~~~~~ %s ~~~~~~~~~~\n", MapKindName(kind));
+	std::printf("%-10s %-18s %10s %8s %8s %12s %10s\n", "pipeline", "stage", "allocs", "p50", "max",
+		"bytes", "max-bytes");
+	bool ok1 = RunAStar(options, kind, mx, queries);
+	bool ok2 = RunFlowField(options, kind, mx, queries);
+	return ok1 && ok2;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.size = ParseIntFlag(argc, argv, "-size", 256);
+	options.numQueries = ParseIntFlag(argc, argv, "-queries", 1000);
+	options.seed = ParseIntFlag(argc, argv, "-seed", 2024);
+	options.step = ParseIntFlag(argc, argv, "-step", 1);
+	options.qrange = ParseIntFlag(argc, argv, "-qrange", 64);
+	int maxAllocs = ParseIntFlag(argc, argv, "-max-allocs", -1);
+	options.maxAllocsAStar = ParseIntFlag(argc, argv, "-max-allocs-astar", maxAllocs);
+	options.maxAllocsFlowField = ParseIntFlag(argc, argv, "-max-allocs-flowfield", maxAllocs);
+	options.mapName = ParseStringFlag(argc, argv, "-map", "all");
+
+	std::printf("size=%d seed=%d queries=%d step=%d qrange=%d (allocations per query)\n", options.size,
+		options.seed, options.numQueries, options.step, options.qrange);
+
+	bool ok = true;
+	for (auto kind : AllMapKinds)
+	{
+		if (options.mapName != "all" && options.mapName != MapKindName(kind))
+			continue;
+		ok = Run(options, kind) && ok;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// QDPF_BenchScen: replays a MovingAI scenario file against AStarPathFinder.
+//
+// Loads the .map into a QuadtreeMapX via a TerrainTypesChecker over the loaded grid, runs each
+// scenario with Reset + ComputeGateRoutes (optionally on a node path), and reports the throughput
+// and the path cost error against the scenario's optimal lengths.
+//
+// The costs of QDPF are divided by CostUnit before being compared to the optimal lengths.
+// MovingAI forbids cutting corners, and QDPF measures straight lines between gate cells by the
+// euclidean distance, so ratios a bit less than 1 are expected.
+//
+// Usage:
+//   QDPF_BenchScen -scen arena.map.scen [-map arena.map] [-step 1] [-max-node-width -1]
+//                  [-limit 0] [-node-path] [-by-bucket]
+//
+// If -map is not given, the map is looked up by the file name of the scenario's map field, in the
+// directory of the scenario file.
+
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BenchmarkMovingAI.h"
+#include "BenchmarkUtil.h"
+#include "QDPF.h"
+
+using namespace QDPF::Benchmark;
+
+struct Options
+{
+	std::string scenPath;
+	std::string mapPath;
+	int			step;
+	int			maxNodeWidth;
+	int			limit;
+	bool		useNodePath;
+	bool		byBucket;
+};
+
+// Returns the directory part of path, including the trailing slash.
+static std::string DirName(const std::string& path)
+{
+	auto p = path.find_last_of("/\\");
+	return p == std::string::npos ? "" : path.substr(0, p + 1);
+}
+
+// Returns the file name part of path.
+static std::string BaseName(const std::string& path)
+{
+	auto p = path.find_last_of("/\\");
+	return p == std::string::npos ? path : path.substr(p + 1);
+}
+
+// Statistics of a group of scenarios.
+struct Result
+{
+	Samples ratios, errors, us;
+	int		failures = 0; // unreachable by QDPF, but reachable in the scenario.
+};
+
+static void PrintResult(const char* name, const Result& r)
+{
+	std::printf("%-8s %6zu %5d | %8.2f %8.2f %8.2f %10.0f | %6.3f %6.3f %6.3f %6.3f %6.3f | %7.2f %7.2f\n",
+		name, r.us.Size(), r.failures, r.us.Mean(), r.us.Percentile(50), r.us.Percentile(99),
+		r.us.Mean() > 0 ? 1e6 / r.us.Mean() : 0, r.ratios.Mean(), r.ratios.Percentile(50),
+		r.ratios.Percentile(90), r.ratios.Percentile(99), r.ratios.Max(), r.errors.Mean(),
+		r.errors.Max());
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	options.scenPath = ParseStringFlag(argc, argv, "-scen", "");
+	options.mapPath = ParseStringFlag(argc, argv, "-map", "");
+	options.step = ParseIntFlag(argc, argv, "-step", 1);
+	options.maxNodeWidth = ParseIntFlag(argc, argv, "-max-node-width", -1);
+	options.limit = ParseIntFlag(argc, argv, "-limit", 0);
+	options.useNodePath = HasFlag(argc, argv, "-node-path");
+	options.byBucket = HasFlag(argc, argv, "-by-bucket");
+
+	if (options.scenPath.empty())
+	{
+		std::fprintf(stderr, "usage: %s -scen <file.scen> [-map <file.map>] [-step 1] "
+							 "[-max-node-width -1] [-limit 0] [-node-path] [-by-bucket]\n",
+			argv[0]);
+		return 1;
+	}
+
+	std::vector<MovingAIScenario> scenarios;
+	if (!LoadMovingAIScenarios(options.scenPath, scenarios) || scenarios.empty())
+	{
+		std::fprintf(stderr, "failed to load scenarios: %s\n", options.scenPath.c_str());
+		return 1;
+	}
+	if (options.limit > 0 && scenarios.size() > options.limit)
+		scenarios.resize(options.limit);
+
+	if (options.mapPath.empty())
+		options.mapPath = DirName(options.scenPath) + BaseName(scenarios[0].map);
+
+	Grid grid(1, 1);
+	if (!LoadMovingAIMap(options.mapPath, grid))
+	{
+		std::fprintf(stderr, "failed to load map: %s\n", options.mapPath.c_str());
+		return 1;
+	}
+
+	// ~~~~~~~~~~ build ~~~~~~~~~~~
+	auto					   distance = QDPF::EuclideanDistance<CostUnit>;
+	QDPF::TerrainTypesChecker  terrainChecker = [&grid](int x, int y) { return grid.Get(x, y); };
+	QDPF::QuadtreeMapXSettings settings{ { CostUnit, Terrain::Land } };
+	QDPF::QuadtreeMapX		   mx(grid.W(), grid.H(), distance, terrainChecker, settings, options.step,
+				  nullptr, options.maxNodeWidth, options.maxNodeWidth);
+
+	Stopwatch sw;
+	mx.Build();
+	double buildMs = sw.ElapsedMs();
+
+	auto m = mx.Get(CostUnit, Terrain::Land);
+	std::printf("map=%s %dx%d step=%d maxNodeWidth=%d build=%.1fms nodes=%zu gates=%zu mode=%s\n",
+		options.mapPath.c_str(), grid.W(), grid.H(), options.step, options.maxNodeWidth, buildMs,
+		m->NumLeafNodes(), m->NumGates(), options.useNodePath ? "node+gate" : "gate");
+
+	// ~~~~~~~~~~ replay ~~~~~~~~~~~
+	QDPF::AStarPathFinder pf(mx);
+	QDPF::NodePath		  nodePath;
+	QDPF::GatePath		  gatePath;
+
+	Result				  total;
+	std::map<int, Result> buckets;
+	int					  skipped = 0;
+
+	for (const auto& s : scenarios)
+	{
+		if (s.x1 >= grid.W() || s.y1 >= grid.H() || s.x2 >= grid.W() || s.y2 >= grid.H())
+		{
+			++skipped;
+			continue;
+		}
+
+		nodePath.clear();
+		gatePath.clear();
+		sw.Reset();
+		int cost = -1;
+		if (pf.Reset(s.x1, s.y1, s.x2, s.y2, CostUnit, Terrain::Land) == 0)
+		{
+			if (!options.useNodePath)
+				cost = pf.ComputeGateRoutes(gatePath);
+			else if (pf.ComputeNodeRoutes(nodePath) != -1)
+				cost = pf.ComputeGateRoutes(gatePath, nodePath);
+		}
+		double us = sw.ElapsedUs();
+
+		for (auto r : { &total, &buckets[s.bucket] })
+		{
+			r->us.Add(us);
+			if (cost == -1)
+				++r->failures;
+			else if (s.optimal > 0)
+			{
+				double length = static_cast<double>(cost) / CostUnit;
+				r->ratios.Add(length / s.optimal);
+				r->errors.Add(std::abs(length - s.optimal));
+			}
+		}
+	}
+
+	std::printf("scenarios=%zu skipped=%d (ratio = cost / optimal length, error = |cost - optimal "
+				"length|)\n",
+		scenarios.size(), skipped);
+	std::printf("%-8s %6s %5s | %8s %8s %8s %10s | %6s %6s %6s %6s %6s | %7s %7s\n", "bucket", "runs",
+		"fail", "mean(us)", "p50(us)", "p99(us)", "queries/s", "mean", "p50", "p90", "p99", "max",
+		"err", "maxerr");
+	if (options.byBucket)
+	{
+		for (const auto& [bucket, r] : buckets)
+			PrintResult(std::to_string(bucket).c_str(), r);
+	}
+	PrintResult("all", total);
+	return 0;
+}
@@ -0,0 +1,324 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "BenchmarkUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+namespace QDPF
+{
+	namespace Benchmark
+	{
+
+		const char* MapKindName(MapKind kind)
+		{
+			switch (kind)
+			{
+				case MapKind::Random:
+					return "random";
+				case MapKind::Maze:
+					return "maze";
+				case MapKind::Rooms:
+					return "rooms";
+				case MapKind::Open:
+					return "open";
+			}
+			return "unknown";
+		}
+
+		///////////////////////////////
+		/// Grid
+		///////////////////////////////
+
+		Grid::Grid(int w, int h, int value)
+			: w(w), h(h), cells(w * h, value) {}
+
+		void Grid::Fill(int x1, int y1, int x2, int y2, int v)
+		{
+			x1 = std::max(0, x1), y1 = std::max(0, y1);
+			x2 = std::min(w - 1, x2), y2 = std::min(h - 1, y2);
+			for (int y = y1; y <= y2; ++y)
+			{
+				for (int x = x1; x <= x2; ++x)
+					cells[y * w + x] = v;
+			}
+		}
+
+		bool Grid::Is(int x, int y, int v) const
+		{
+			if (!(x >= 0 && x < w && y >= 0 && y < h))
+				return false;
+			return Get(x, y) == v;
+		}
+
+		///////////////////////////////
+		/// Map Generators
+		///////////////////////////////
+
+		// Places random square blocks of buildings until the given density of cells are covered.
+		// The side length of each block is picked randomly in [1, maxBlockSize].
+		static void GenerateRandomBlocks(Grid& grid, std::mt19937& rng, double density, int maxBlockSize)
+		{
+			int w = grid.W(), h = grid.H();
+			int target = static_cast<int>(density * w * h);
+			int covered = 0;
+
+			std::uniform_int_distribution<int> rx(0, w - 1), ry(0, h - 1), rs(1, maxBlockSize);
+
+			while (covered < target)
+			{
+				int x1 = rx(rng), y1 = ry(rng), k = rs(rng);
+				int x2 = std::min(w - 1, x1 + k - 1), y2 = std::min(h - 1, y1 + k - 1);
+				for (int y = y1; y <= y2; ++y)
+				{
+					for (int x = x1; x <= x2; ++x)
+					{
+						if (grid.Get(x, y) != Terrain::Building)
+						{
+							grid.Set(x, y, Terrain::Building);
+							++covered;
+						}
+					}
+				}
+			}
+		}
+
+		// Carves a maze via an iterative randomized depth-first search.
+		// Corridors are `corridor` cells wide, walls are one cell thick.
+		static void GenerateMaze(Grid& grid, std::mt19937& rng, int corridor)
+		{
+			int w = grid.W(), h = grid.H();
+			int k = corridor + 1;
+			int nx = std::max(1, (w - 1) / k), ny = std::max(1, (h - 1) / k);
+
+			grid.Fill(0, 0, w - 1, h - 1, Terrain::Building);
+
+			// left-top corner of maze cell (i,j).
+			auto x0 = [k](int i) { return 1 + i * k; };
+			auto y0 = [k](int j) { return 1 + j * k; };
+
+			for (int j = 0; j < ny; ++j)
+			{
+				for (int i = 0; i < nx; ++i)
+					grid.Fill(x0(i), y0(j), x0(i) + corridor - 1, y0(j) + corridor - 1, Terrain::Land);
+			}
+
+			// directions: { di, dj }
+			const int DIRECTIONS[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+
+			std::vector<unsigned char>		 vis(nx * ny, 0);
+			std::vector<std::pair<int, int>> stack;
+			stack.push_back({ 0, 0 });
+			vis[0] = 1;
+
+			while (stack.size())
+			{
+				auto [i, j] = stack.back();
+
+				int candidates[4], n = 0;
+				for (int d = 0; d < 4; ++d)
+				{
+					int i1 = i + DIRECTIONS[d][0], j1 = j + DIRECTIONS[d][1];
+					if (i1 >= 0 && i1 < nx && j1 >= 0 && j1 < ny && !vis[j1 * nx + i1])
+						candidates[n++] = d;
+				}
+				if (n == 0)
+				{
+					stack.pop_back();
+					continue;
+				}
+
+				int d = candidates[std::uniform_int_distribution<int>(0, n - 1)(rng)];
+				int i1 = i + DIRECTIONS[d][0], j1 = j + DIRECTIONS[d][1];
+
+				// knock down the wall between (i,j) and (i1,j1).
+				int ax = std::min(i, i1), ay = std::min(j, j1);
+				if (i != i1) // horizontal: the wall column right to the left one.
+					grid.Fill(x0(ax) + corridor, y0(j), x0(ax) + corridor, y0(j) + corridor - 1, Terrain::Land);
+				else // vertical: the wall row below the upper one.
+					grid.Fill(x0(i), y0(ay) + corridor, x0(i) + corridor - 1, y0(ay) + corridor, Terrain::Land);
+
+				vis[j1 * nx + i1] = 1;
+				stack.push_back({ i1, j1 });
+			}
+		}
+
+		// Places random rooms, and connects each room to the previous one with an L-shaped corridor.
+		static void GenerateRooms(Grid& grid, std::mt19937& rng)
+		{
+			int w = grid.W(), h = grid.H();
+			grid.Fill(0, 0, w - 1, h - 1, Terrain::Building);
+
+			int minRoomSize = 6, maxRoomSize = std::max(minRoomSize, std::min(24, std::min(w, h) / 4));
+			int numRooms = std::max(4, (w * h) / 2048);
+			int corridor = 2;
+
+			std::uniform_int_distribution<int> rs(minRoomSize, maxRoomSize);
+
+			int px = -1, py = -1; // center of previous room
+			for (int r = 0; r < numRooms; ++r)
+			{
+				int rw = rs(rng), rh = rs(rng);
+				int x1 = std::uniform_int_distribution<int>(1, std::max(1, w - rw - 1))(rng);
+				int y1 = std::uniform_int_distribution<int>(1, std::max(1, h - rh - 1))(rng);
+				grid.Fill(x1, y1, x1 + rw - 1, y1 + rh - 1, Terrain::Land);
+
+				int cx = x1 + rw / 2, cy = y1 + rh / 2;
+				if (px != -1)
+				{
+					// horizontal leg then vertical leg.
+					grid.Fill(std::min(px, cx), py, std::max(px, cx), py + corridor - 1, Terrain::Land);
+					grid.Fill(cx, std::min(py, cy), cx + corridor - 1, std::max(py, cy), Terrain::Land);
+				}
+				px = cx, py = cy;
+			}
+		}
+
+		void GenerateMap(MapKind kind, Grid& grid, std::uint32_t seed)
+		{
+			std::mt19937 rng(seed);
+			grid.Fill(0, 0, grid.W() - 1, grid.H() - 1, Terrain::Land);
+
+			switch (kind)
+			{
+				case MapKind::Random:
+					GenerateRandomBlocks(grid, rng, 0.25, 8);
+					break;
+				case MapKind::Maze:
+					GenerateMaze(grid, rng, 4);
+					break;
+				case MapKind::Rooms:
+					GenerateRooms(grid, rng);
+					break;
+				case MapKind::Open:
+					GenerateRandomBlocks(grid, rng, 0.02, 4);
+					break;
+			}
+		}
+
+		void GenerateLakes(Grid& grid, std::uint32_t seed)
+		{
+			std::mt19937					   rng(seed);
+			std::uniform_int_distribution<int> rx(0, grid.W() - 1), ry(0, grid.H() - 1), rs(4, 24);
+
+			for (int i = 0; i < grid.W() * grid.H() / 4096; ++i)
+			{
+				int x1 = rx(rng), y1 = ry(rng), k = rs(rng);
+				grid.Fill(x1, y1, x1 + k - 1, y1 + k - 1, Terrain::Water);
+			}
+		}
+
+		void GenerateQueries(const Grid& grid, int n, std::uint32_t seed, std::vector<Query>& queries,
+			int terrain)
+		{
+			std::mt19937					   rng(seed);
+			std::uniform_int_distribution<int> rx(0, grid.W() - 1), ry(0, grid.H() - 1);
+
+			// picks a random cell of given terrain, gives up after too many attempts.
+			auto pick = [&](int& x, int& y) {
+				for (int attempts = 0; attempts < 1000; ++attempts)
+				{
+					x = rx(rng), y = ry(rng);
+					if (grid.Get(x, y) == terrain)
+						return true;
+				}
+				return false;
+			};
+
+			for (int i = 0; i < n; ++i)
+			{
+				int x1, y1, x2, y2;
+				if (!pick(x1, y1) || !pick(x2, y2))
+					break;
+				queries.push_back({ x1, y1, x2, y2 });
+			}
+		}
+
+		///////////////////////////////
+		/// Stopwatch && Samples
+		///////////////////////////////
+
+		double Stopwatch::ElapsedUs() const
+		{
+			auto d = std::chrono::steady_clock::now() - start;
+			return std::chrono::duration<double, std::micro>(d).count();
+		}
+
+		double Samples::Mean() const
+		{
+			if (values.empty())
+				return 0;
+			return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+		}
+
+		double Samples::Max() const
+		{
+			if (values.empty())
+				return 0;
+			return *std::max_element(values.begin(), values.end());
+		}
+
+		double Samples::Percentile(double p) const
+		{
+			if (values.empty())
+				return 0;
+			std::vector<double> sorted(values);
+			std::sort(sorted.begin(), sorted.end());
+			// nearest-rank: the smallest value that p percents of samples are less or equal than.
+			auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * sorted.size()));
+			rank = std::clamp<std::size_t>(rank, 1, sorted.size());
+			return sorted[rank - 1];
+		}
+
+		///////////////////////////////
+		/// Command line flags
+		///////////////////////////////
+
+		int ParseIntFlag(int argc, char* argv[], const char* name, int defaultValue)
+		{
+			for (int i = 1; i + 1 < argc; ++i)
+			{
+				if (std::strcmp(argv[i], name) == 0)
+					return std::atoi(argv[i + 1]);
+			}
+			return defaultValue;
+		}
+
+		double ParseDoubleFlag(int argc, char* argv[], const char* name, double defaultValue)
+		{
+			for (int i = 1; i + 1 < argc; ++i)
+			{
+				if (std::strcmp(argv[i], name) == 0)
+					return std::atof(argv[i + 1]);
+			}
+			return defaultValue;
+		}
+
+		std::string ParseStringFlag(int argc, char* argv[], const char* name,
+			const std::string& defaultValue)
+		{
+			for (int i = 1; i + 1 < argc; ++i)
+			{
+				if (std::strcmp(argv[i], name) == 0)
+					return argv[i + 1];
+			}
+			return defaultValue;
+		}
+
+		bool HasFlag(int argc, char* argv[], const char* name)
+		{
+			for (int i = 1; i < argc; ++i)
+			{
+				if (std::strcmp(argv[i], name) == 0)
+					return true;
+			}
+			return false;
+		}
+
+	} // namespace Benchmark
+} // namespace QDPF
@@ -0,0 +1,147 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+// Shared utilities for the benchmark executables.
+// **NOTE**: This file is NOT required to use quadtree-pathfinding.
+
+#ifndef QDPF_BENCHMARK_UTIL_HPP
+#define QDPF_BENCHMARK_UTIL_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace QDPF
+{
+	namespace Benchmark
+	{
+
+		// Terrain values used by the generated maps.
+		enum Terrain
+		{
+			Land = 0b001,	  // 1
+			Water = 0b010,	  // 2
+			Building = 0b100, // 4
+		};
+
+		// CostUnit of the euclidean distance calculator used by all benchmarks.
+		const int CostUnit = 10;
+
+		// Kinds of generated maps.
+		enum class MapKind
+		{
+			// Random square blocks of buildings, until a given obstacle density is reached.
+			Random = 0,
+			// A maze of corridors with one-cell thick walls.
+			Maze = 1,
+			// Rectangular rooms connected by L-shaped corridors, everything else is walls.
+			Rooms = 2,
+			// Almost empty land with sparse small obstacles.
+			Open = 3,
+		};
+
+		// All map kinds, in order.
+		const MapKind AllMapKinds[] = { MapKind::Random, MapKind::Maze, MapKind::Rooms, MapKind::Open };
+
+		// Returns a short name of given map kind.
+		const char* MapKindName(MapKind kind);
+
+		// Grid is a generated 2D grid map of terrain values.
+		class Grid
+		{
+		public:
+			Grid(int w, int h, int value = Terrain::Land);
+
+			int W() const { return w; }
+			int H() const { return h; }
+
+			// Returns the terrain value of cell (x,y).
+			int	 Get(int x, int y) const { return cells[y * w + x]; }
+			void Set(int x, int y, int v) { cells[y * w + x] = v; }
+
+			// Sets all cells inside rectangle (x1,y1),(x2,y2) to value v, clipped by the map bounds.
+			void Fill(int x1, int y1, int x2, int y2, int v);
+
+			// Returns true if cell (x,y) is inside the map and its terrain value is v.
+			bool Is(int x, int y, int v) const;
+
+		private:
+			int				   w, h;
+			std::vector<short> cells;
+		};
+
+		// Generates a map of given kind into grid.
+		// The same seed always generates the same map.
+		void GenerateMap(MapKind kind, Grid& grid, std::uint32_t seed);
+
+		// Paints random square lakes of water (4x4 ~ 24x24) onto the grid, one per 64x64 cells.
+		// So that settings walking on water are also relevant on generated maps.
+		void GenerateLakes(Grid& grid, std::uint32_t seed);
+
+		// Query is a pair of start and target cells: { x1, y1, x2, y2 }.
+		using Query = std::tuple<int, int, int, int>;
+
+		// Picks n random pairs of start and target cells on given terrain value.
+		// Pairs are picked from the same seed, so they are stable across runs.
+		void GenerateQueries(const Grid& grid, int n, std::uint32_t seed, std::vector<Query>& queries,
+			int terrain = Terrain::Land);
+
+		// Stopwatch measures the elapsed time since the last Reset().
+		class Stopwatch
+		{
+		public:
+			Stopwatch() { Reset(); }
+			void Reset() { start = std::chrono::steady_clock::now(); }
+
+			// Returns the elapsed microseconds.
+			double ElapsedUs() const;
+
+			// Returns the elapsed milliseconds.
+			double ElapsedMs() const { return ElapsedUs() / 1000.0; }
+
+		private:
+			std::chrono::steady_clock::time_point start;
+		};
+
+		// Samples collects measured values and reports simple statistics.
+		class Samples
+		{
+		public:
+			void		Add(double v) { values.push_back(v); }
+			void		Clear() { values.clear(); }
+			std::size_t Size() const { return values.size(); }
+
+			double Mean() const;
+			double Max() const;
+
+			// Returns the p-th percentile (0 <= p <= 100) using the nearest-rank method.
+			// Returns 0 if there's no samples.
+			double Percentile(double p) const;
+
+		private:
+			std::vector<double> values;
+		};
+
+		// Returns the integer value of command line flag name, e.g. "-queries 100".
+		// Returns the defaultValue if the flag is not found.
+		int ParseIntFlag(int argc, char* argv[], const char* name, int defaultValue);
+
+		// Returns the floating value of command line flag name, e.g. "-tolerance 0.2".
+		// Returns the defaultValue if the flag is not found.
+		double ParseDoubleFlag(int argc, char* argv[], const char* name, double defaultValue);
+
+		// Returns the string value of command line flag name, e.g. "-scen a.scen".
+		// Returns the defaultValue if the flag is not found.
+		std::string ParseStringFlag(int argc, char* argv[], const char* name,
+			const std::string& defaultValue);
+
+		// Returns true if command line flag name is present, e.g. "-no-naive".
+		bool HasFlag(int argc, char* argv[], const char* name);
+
+	} // namespace Benchmark
+} // namespace QDPF
+
+#endif
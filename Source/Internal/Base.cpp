@@ -91,5 +91,24 @@ namespace QDPF
 			return h;
 		}
 
+		void Histogram::Add(std::size_t v)
+		{
+			auto k = BucketOf(v);
+			if (Buckets.size() <= k)
+				Buckets.resize(k + 1, 0);
+			++Buckets[k];
+			++NumSamples;
+			Sum += v;
+			Max = std::max(Max, v);
+		}
+
+		int Histogram::BucketOf(std::size_t v)
+		{
+			int k = 0;
+			while (v)
+				v >>= 1, ++k;
+			return k;
+		}
+
 	} // namespace Internal
 } // namespace QDPF
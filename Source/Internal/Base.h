@@ -4,8 +4,11 @@
 #ifndef QDPF_INTERNAL_BASE_HPP
 #define QDPF_INTERNAL_BASE_HPP
 
+#include <algorithm> // for std::fill
+#include <cstddef>	 // for std::size_t
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility> // for std::pair
 #include <vector>
 
@@ -72,6 +75,64 @@ namespace QDPF
 			}
 		};
 
+		// ~~~~~~~~~~~ Memory Estimation ~~~~~~~~~~~~
+
+		// MemoryUsage is the number of entries and the estimated heap bytes of a container.
+		struct MemoryUsage
+		{
+			std::size_t NumEntries = 0;
+			std::size_t Bytes = 0;
+
+			MemoryUsage& operator+=(const MemoryUsage& o)
+			{
+				NumEntries += o.NumEntries, Bytes += o.Bytes;
+				return *this;
+			}
+		};
+
+		// Estimated heap bytes of a hash node: the item, the next pointer and the cached hash.
+		template <typename T>
+		constexpr std::size_t HashNodeBytes = sizeof(T) + sizeof(void*) + sizeof(std::size_t);
+
+		// Estimates the heap bytes of an unordered_map, excluding the heap memory owned by its values.
+		// The estimation assumes the common layout: a bucket array of pointers, and a node per item.
+		template <typename K, typename V, typename Hasher>
+		std::size_t EstimateMemoryBytes(const std::unordered_map<K, V, Hasher>& m)
+		{
+			return m.bucket_count() * sizeof(void*) + m.size() * HashNodeBytes<std::pair<const K, V>>;
+		}
+
+		// Estimates the heap bytes of an unordered_set.
+		template <typename K, typename Hasher>
+		std::size_t EstimateMemoryBytes(const std::unordered_set<K, Hasher>& st)
+		{
+			return st.bucket_count() * sizeof(void*) + st.size() * HashNodeBytes<K>;
+		}
+
+		// Estimates the heap bytes of a vector, excluding the heap memory owned by its items.
+		template <typename T>
+		std::size_t EstimateMemoryBytes(const std::vector<T>& vec)
+		{
+			return vec.capacity() * sizeof(T);
+		}
+
+		// Histogram of non-negative integer values on power-of-2 buckets.
+		// Buckets[0] counts the value 0, and Buckets[k] (k >= 1) counts values in [2^(k-1), 2^k).
+		struct Histogram
+		{
+			std::vector<std::size_t> Buckets;
+			std::size_t				 NumSamples = 0, Sum = 0, Max = 0;
+
+			// Adds a value to the histogram.
+			void Add(std::size_t v);
+
+			// Returns the index of the bucket that the value v falls into.
+			static int BucketOf(std::size_t v);
+
+			// Returns the mean of all values, 0 if there's no values.
+			double Mean() const { return NumSamples ? static_cast<double>(Sum) / NumSamples : 0; }
+		};
+
 		// ~~~~~~~~~~~ Util Containers ~~~~~~~~~~~~
 
 		// A simple simple unordered_map with default value.
@@ -109,6 +170,9 @@ namespace QDPF
 
 			void Erase(K k) { m.erase(k); }
 
+			// Returns the estimated heap bytes.
+			std::size_t MemoryBytes() const { return EstimateMemoryBytes(m); }
+
 		private:
 			V					   defaultValue = DefaultValue;
 			UnderlyingUnorderedMap m;
@@ -157,6 +221,15 @@ namespace QDPF
 
 			void Erase(K1 k1) { m.erase(k1); }
 
+			// Returns the estimated heap bytes, including the inner maps.
+			std::size_t MemoryBytes() const
+			{
+				auto n = EstimateMemoryBytes(m);
+				for (auto& [_, inner] : m)
+					n += inner.MemoryBytes();
+				return n;
+			}
+
 		private:
 			V defaultValue = DefaultValue;
 
@@ -199,6 +272,15 @@ namespace QDPF
 
 			void Erase(K1 k1) { m.erase(k1); }
 
+			// Returns the estimated heap bytes, including the inner maps.
+			std::size_t MemoryBytes() const
+			{
+				auto n = EstimateMemoryBytes(m);
+				for (auto& [_, inner] : m)
+					n += inner.MemoryBytes();
+				return n;
+			}
+
 		private:
 			V defaultValue = DefaultValue;
 
@@ -235,6 +317,60 @@ namespace QDPF
 		template <bool DefaultValue>
 		using DefaultedVectorBool = DefaultedVector<unsigned char, DefaultValue>;
 
+		// StampedVector is a DefaultedVector which can be cleared in O(1) by NewGeneration.
+		// Each item is stamped with the generation it's written in, items of older generations read as
+		// the default value. It's for containers reused across rounds without clearings.
+		template <typename V, V DefaultValue>
+		class StampedVector
+		{
+		public:
+			// Resize the vector to at least n items, it never shrinks.
+			void Resize(std::size_t n)
+			{
+				if (n > vec.size())
+				{
+					vec.resize(n, DefaultValue);
+					stamps.resize(n, 0);
+				}
+			}
+
+			// Resets all the items to the default value.
+			void NewGeneration()
+			{
+				// the generation wraps around, rare.
+				if (++generation == 0)
+				{
+					std::fill(stamps.begin(), stamps.end(), 0);
+					generation = 1;
+				}
+			}
+
+			// Returns a mutable reference to the kth item.
+			V& operator[](int k)
+			{
+				if (stamps[k] != generation)
+				{
+					stamps[k] = generation;
+					vec[k] = DefaultValue;
+				}
+				return vec[k];
+			}
+
+			// Returns the value of the kth item.
+			V operator[](int k) const { return stamps[k] == generation ? vec[k] : DefaultValue; }
+
+		private:
+			std::vector<V>			  vec;
+			std::vector<unsigned int> stamps;
+			unsigned int			  generation = 1;
+		};
+
+		template <int DefaultValue>
+		using StampedVectorInt = StampedVector<int, DefaultValue>;
+
+		template <bool DefaultValue>
+		using StampedVectorBool = StampedVector<unsigned char, DefaultValue>;
+
 	} // namespace Internal
 } // namespace QDPF
 
@@ -0,0 +1,254 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "ContractionHierarchy.h"
+
+#include <algorithm> // for std::sort, std::push_heap, std::pop_heap, std::max
+#include <functional> // for std::greater
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		// max number of vertices settled by a witness search, a search giving up adds the shortcuts,
+		// which are redundant but harmless.
+		const int MaxWitnessSettled = 32;
+
+		// max mean degree of the edge ends (sum of squared degrees over sum of degrees) of the graph to
+		// contract.
+		const std::size_t MaxDensity = 16;
+
+		// max number of shortcuts per edge of the graph to contract.
+		const std::size_t MaxShortcutsPerEdge = 2;
+
+		std::size_t ContractionHierarchy::MemoryBytes() const
+		{
+			return EstimateMemoryBytes(rank) + EstimateMemoryBytes(offsets) + EstimateMemoryBytes(edges);
+		}
+
+		const ContractionHierarchy::Edge* ContractionHierarchy::FindEdge(int u, int v) const
+		{
+			if (rank[u] > rank[v])
+				std::swap(u, v);
+			for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+			{
+				if (edges[k].to == v)
+					return &edges[k];
+			}
+			return nullptr;
+		}
+
+		// Contracts all vertices, from the lowest priority to the highest. The priority of a vertex is
+		// updated lazily: it's computed again on popping, and pushed back if it's not the lowest any
+		// more. ups[v] collects the edges of v to the vertices contracted after it.
+		// Returns false if the graph is too dense or too many shortcuts are added.
+		bool ContractionHierarchy::Contract(std::vector<std::vector<Edge>>& ups)
+		{
+			// the gate graph doesn't check duplicate edges, keeps the cheapest one of each pair.
+			for (auto& list : adj)
+			{
+				std::sort(list.begin(), list.end(),
+					[](const Edge& a, const Edge& b) { return a.to < b.to || (a.to == b.to && a.cost < b.cost); });
+				list.erase(std::unique(list.begin(), list.end(),
+							   [](const Edge& a, const Edge& b) { return a.to == b.to; }),
+					list.end());
+			}
+
+			// a witness search costs about the square of the degree of the vertex to contract, gives up
+			// if the mean degree of the edge ends is too large, before any search.
+			std::size_t sumDegrees = 0, sumSquaredDegrees = 0;
+			for (const auto& list : adj)
+				sumDegrees += list.size(), sumSquaredDegrees += list.size() * list.size();
+			if (sumSquaredDegrees > MaxDensity * sumDegrees)
+			{
+				FreeBuffers();
+				return false;
+			}
+			// each edge is counted from both ends.
+			std::size_t maxShortcuts = MaxShortcutsPerEdge * sumDegrees / 2;
+
+			rank.assign(n, -1);
+			numContractedNeighbours.assign(n, 0);
+			witness.assign(n, inf);
+			targetCost.assign(n, inf);
+			stamps.assign(n, 0);
+			stamp = 0;
+			positions.assign(n, -1);
+
+			// smallest-first heap of { priority, vertex }.
+			std::vector<std::pair<int, int>> order;
+			order.reserve(n);
+			for (int v = 0; v < n; ++v)
+				order.push_back({ Priority(v), v });
+			std::make_heap(order.begin(), order.end(), std::greater<std::pair<int, int>>());
+
+			int			r = 0;
+			std::size_t numAdded = 0;
+			while (!order.empty())
+			{
+				std::pop_heap(order.begin(), order.end(), std::greater<std::pair<int, int>>());
+				int v = order.back().second;
+				order.pop_back();
+				int p = Priority(v);
+				if (!order.empty() && p > order.front().first)
+				{
+					order.push_back({ p, v });
+					std::push_heap(order.begin(), order.end(), std::greater<std::pair<int, int>>());
+					continue;
+				}
+				// the shortcuts are found by the Priority(v) just now, grouped by the former end u.
+				for (int i = 0; i < shortcuts.size();)
+				{
+					int u = std::get<0>(shortcuts[i]);
+					for (int k = 0; k < adj[u].size(); ++k)
+						positions[adj[u][k].to] = k;
+					for (; i < shortcuts.size() && std::get<0>(shortcuts[i]) == u; ++i)
+						AddShortcut(u, std::get<1>(shortcuts[i]), std::get<2>(shortcuts[i]), v);
+					for (const auto& e : adj[u])
+						positions[e.to] = -1;
+				}
+				numAdded += shortcuts.size();
+				if (numAdded > maxShortcuts)
+				{
+					FreeBuffers();
+					rank.clear();
+					return false;
+				}
+				rank[v] = r++;
+				// removes v from the remaining graph, its edges go upward.
+				for (const auto& e : adj[v])
+				{
+					auto& list = adj[e.to];
+					for (int k = 0; k < list.size(); ++k)
+					{
+						if (list[k].to == v)
+						{
+							list[k] = list.back();
+							list.pop_back();
+							break;
+						}
+					}
+					++numContractedNeighbours[e.to];
+				}
+				ups[v] = std::move(adj[v]);
+			}
+			FreeBuffers();
+			return true;
+		}
+
+		void ContractionHierarchy::FreeBuffers()
+		{
+			std::vector<std::vector<Edge>>().swap(adj);
+			std::vector<int>().swap(numContractedNeighbours);
+			std::vector<std::pair<int, int>>().swap(q);
+			std::vector<int>().swap(witness);
+			std::vector<int>().swap(targetCost);
+			std::vector<int>().swap(stamps);
+			std::vector<int>().swap(positions);
+			std::vector<std::tuple<int, int, int>>().swap(shortcuts);
+		}
+
+		// The priority of contracting v: the number of shortcuts to add minus the edges to remove, so
+		// the graph keeps sparse, plus the number of contracted neighbours, so the contracted vertices
+		// spread evenly.
+		int ContractionHierarchy::Priority(int v)
+		{
+			FindShortcuts(v);
+			return static_cast<int>(shortcuts.size()) - static_cast<int>(adj[v].size())
+				+ numContractedNeighbours[v];
+		}
+
+		// Finds the shortcuts to add for contracting v.
+		void ContractionHierarchy::FindShortcuts(int v)
+		{
+			const auto& nb = adj[v];
+			shortcuts.clear();
+			// each pair of neighbours (u,w) is checked once, from the former one u.
+			for (int a = 0; a + 1 < nb.size(); ++a)
+			{
+				int u = nb[a].to, cu = nb[a].cost, maxCost = 0;
+				++stamp;
+				for (int b = a + 1; b < nb.size(); ++b)
+				{
+					int w = nb[b].to;
+					stamps[w] = stamp, witness[w] = inf, targetCost[w] = cu + nb[b].cost;
+					maxCost = std::max(maxCost, targetCost[w]);
+				}
+				WitnessSearch(u, v, maxCost, nb.size() - a - 1);
+				for (int b = a + 1; b < nb.size(); ++b)
+				{
+					int w = nb[b].to, cost = cu + nb[b].cost;
+					if (WitnessOf(w) > cost)
+						shortcuts.push_back({ u, w, cost });
+				}
+			}
+		}
+
+		// Searches the paths from u to the targets not through v, within maxCost.
+		// Stops once each target is reached within the cost of the path through v (a witness), it
+		// doesn't need to be the shortest one.
+		void ContractionHierarchy::WitnessSearch(int u, int v, int maxCost, int numTargets)
+		{
+			int numWitnessed = 0, numSettled = 0;
+
+			// the targets are stamped with distance inf, the others are not stamped.
+			auto relax = [this, &numWitnessed](int w, int d) {
+				if (stamps[w] != stamp)
+					stamps[w] = stamp, witness[w] = inf, targetCost[w] = -1;
+				if (d >= witness[w])
+					return;
+				if (d <= targetCost[w] && witness[w] > targetCost[w])
+					++numWitnessed;
+				witness[w] = d;
+				q.push_back({ d, w });
+				std::push_heap(q.begin(), q.end(), std::greater<std::pair<int, int>>());
+			};
+
+			q.clear();
+			relax(u, 0);
+			while (!q.empty() && numWitnessed < numTargets && numSettled < MaxWitnessSettled)
+			{
+				std::pop_heap(q.begin(), q.end(), std::greater<std::pair<int, int>>());
+				auto [d, x] = q.back();
+				q.pop_back();
+				if (d > witness[x])
+					continue; // stale
+				if (d > maxCost)
+					break;
+				++numSettled;
+				for (const auto& e : adj[x])
+				{
+					if (e.to != v && d + e.cost <= maxCost)
+						relax(e.to, d + e.cost);
+				}
+			}
+		}
+
+		// Adds a shortcut between u and w through v, or updates the edge between them if it's cheaper.
+		// The edges of u are indexed by positions.
+		void ContractionHierarchy::AddShortcut(int u, int w, int cost, int v)
+		{
+			int k = positions[w];
+			if (k == -1)
+			{
+				positions[w] = adj[u].size();
+				adj[u].push_back({ w, cost, v });
+				adj[w].push_back({ u, cost, v });
+				return;
+			}
+			if (cost >= adj[u][k].cost)
+				return;
+			adj[u][k].cost = cost, adj[u][k].middle = v;
+			for (auto& e : adj[w])
+			{
+				if (e.to == u)
+				{
+					e.cost = cost, e.middle = v;
+					break;
+				}
+			}
+		}
+
+	} // namespace Internal
+} // namespace QDPF
@@ -0,0 +1,184 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#ifndef QDPF_INTERNAL_CONTRACTION_HIERARCHY_HPP
+#define QDPF_INTERNAL_CONTRACTION_HIERARCHY_HPP
+
+#include <cstddef> // for std::size_t
+#include <tuple>   // for std::tuple
+#include <utility> // for std::pair
+#include <vector>  // for std::vector
+
+#include "Base.h"
+
+// ContractionHierarchy
+// ~~~~~~~~~~~~~~~~~~~~
+// A contraction hierarchy index on a symmetric graph, for fast shortest path queries on static maps.
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		// ContractionHierarchy contracts the vertices of a symmetric graph (the edge u->v exists along
+		// with v->u of the same cost) one by one, from the least important ones. Contracting a vertex v
+		// removes it from the graph, and adds a shortcut u->w (through v) for each pair of its
+		// neighbours if u->v->w is the only shortest path between them. The order of contraction is the
+		// rank of a vertex.
+		//
+		// A shortest path between any two vertices is then a path going up (to higher ranks) from the
+		// start and then going down to the target, on the graph with shortcuts. So a query is two
+		// dijkstra searches on the upward edges only, one from the start and one from the target, which
+		// visit a tiny part of the graph (see ContractionHierarchySearch).
+		//
+		// The graph is on dense vertices in range [0, n), given by two callables:
+		// 1. isVertex: bool(int v), returns true if the index v is in use.
+		// 2. neighbours: void(int u, Visitor& visitor), visits the neighbours of u, the visitor is a
+		//    callable void(int v, int cost).
+		class ContractionHierarchy
+		{
+		public:
+			// Builds the index on the graph of n vertices. The graph is copied.
+			// Gives up and returns false on the graphs without bottlenecks, e.g. the gate graphs of open
+			// fields, made of large cliques, where the index is costly to build and doesn't speed up the
+			// queries: if the graph is too dense, or the shortcuts outnumber the edges by far. The index
+			// is empty then.
+			template <typename IsVertexF, typename NeighboursF>
+			bool Build(int n, IsVertexF&& isVertex, NeighboursF&& neighbours);
+
+			// Returns the upper bound (exclusive) of the vertices.
+			int N() const { return n; }
+
+			// Visits the upward edges of vertex u, to the vertices of higher ranks.
+			// The visitor is any callable of signature void(int v, int cost).
+			template <typename Visitor>
+			void ForEachUpNeighbours(int u, Visitor&& visitor) const;
+
+			// Visits the vertices of the original path which the edge (u,v) (or shortcut) stands for,
+			// from u (exclusive) to v, along with the cost of the original edge to each.
+			// The edge (u,v) must exist on the hierarchy, in either direction.
+			// The visitor is any callable of signature void(int w, int cost).
+			template <typename Visitor>
+			void Unpack(int u, int v, Visitor&& visitor) const;
+
+			// Returns the number of upward edges, and how many of them are shortcuts.
+			std::size_t NumEdges() const { return edges.size(); }
+			std::size_t NumShortcuts() const { return numShortcuts; }
+
+			// Returns the estimated heap bytes.
+			std::size_t MemoryBytes() const;
+
+		private:
+			struct Edge
+			{
+				int to, cost;
+				// the contracted vertex the shortcut passes through, -1 for an original edge.
+				int middle;
+			};
+
+			int n = 0;
+			// rank[v] is the order v is contracted.
+			std::vector<int> rank;
+			// the upward edges of vertex v are edges[offsets[v]..offsets[v+1]).
+			std::vector<int>  offsets;
+			std::vector<Edge> edges;
+			std::size_t		  numShortcuts = 0;
+
+			// Returns the edge between u and v, stored on the lower ranked one. nullptr if not found.
+			const Edge* FindEdge(int u, int v) const;
+
+			// ~~~~~~ building ~~~~~~
+			// the remaining graph, edges between the vertices not contracted yet.
+			std::vector<std::vector<Edge>> adj;
+			// number of contracted neighbours of each vertex.
+			std::vector<int> numContractedNeighbours;
+			// the witness search, on a smallest-first binary heap of { distance, vertex }, with stamped
+			// distances.
+			std::vector<std::pair<int, int>> q;
+			// witness[w] is the distance found to w, targetCost[w] is the cost of the path through the
+			// contracted vertex to w, both valid if stamped.
+			std::vector<int> witness, targetCost, stamps;
+			int				 stamp = 0;
+			// the shortcuts { u, w, cost } found by the last FindShortcuts, and positions[w] is the index
+			// of the edge u->w in adj[u] on adding them, -1 for none.
+			std::vector<std::tuple<int, int, int>> shortcuts;
+			std::vector<int>					   positions;
+
+			bool Contract(std::vector<std::vector<Edge>>& ups);
+			void FindShortcuts(int v);
+			int	 Priority(int v);
+			void WitnessSearch(int u, int v, int maxCost, int numTargets);
+			void FreeBuffers();
+			int	 WitnessOf(int w) const { return stamps[w] == stamp ? witness[w] : inf; }
+			void AddShortcut(int u, int w, int cost, int v);
+		};
+
+		//////////////////////////////////////////
+		/// Implementation for Templated Functions
+		//////////////////////////////////////////
+
+		template <typename IsVertexF, typename NeighboursF>
+		bool ContractionHierarchy::Build(int n, IsVertexF&& isVertex, NeighboursF&& neighbours)
+		{
+			this->n = n;
+			rank.clear(), offsets.clear(), edges.clear();
+			numShortcuts = 0;
+
+			adj.assign(n, {});
+			std::vector<Edge>* list;
+			auto			   collect = [&list](int v, int cost) { list->push_back({ v, cost, -1 }); };
+			for (int u = 0; u < n; ++u)
+			{
+				if (!isVertex(u))
+					continue;
+				list = &adj[u];
+				neighbours(u, collect);
+			}
+			std::vector<std::vector<Edge>> ups(n);
+			if (!Contract(ups))
+			{
+				this->n = 0;
+				return false;
+			}
+
+			// flattens the upward edges.
+			offsets.assign(n + 1, 0);
+			for (int u = 0; u < n; ++u)
+			{
+				for (const auto& e : ups[u])
+				{
+					edges.push_back(e);
+					if (e.middle != -1)
+						++numShortcuts;
+				}
+				offsets[u + 1] = edges.size();
+			}
+			return true;
+		}
+
+		template <typename Visitor>
+		void ContractionHierarchy::ForEachUpNeighbours(int u, Visitor&& visitor) const
+		{
+			for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+				visitor(edges[k].to, edges[k].cost);
+		}
+
+		template <typename Visitor>
+		void ContractionHierarchy::Unpack(int u, int v, Visitor&& visitor) const
+		{
+			// a shortcut (u,v) through m unpacks into (u,m) and (m,v), the depth of the recursion is at
+			// most the number of levels of the hierarchy.
+			const Edge* e = FindEdge(u, v);
+			if (e->middle == -1)
+			{
+				visitor(v, e->cost);
+				return;
+			}
+			Unpack(u, e->middle, visitor);
+			Unpack(e->middle, v, visitor);
+		}
+
+	} // namespace Internal
+} // namespace QDPF
+
+#endif
@@ -0,0 +1,36 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "DistanceOracle.h"
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		std::size_t DistanceOracle::NumEntries() const
+		{
+			std::size_t n = 0;
+			for (const auto& c : components)
+				n += c.dist.size();
+			return n;
+		}
+
+		std::size_t DistanceOracle::MemoryBytes() const
+		{
+			std::size_t n = EstimateMemoryBytes(componentOf) + EstimateMemoryBytes(localIndex)
+				+ EstimateMemoryBytes(components) + EstimateMemoryBytes(touched) + EstimateMemoryBytes(offsets)
+				+ EstimateMemoryBytes(edges) + EstimateMemoryBytes(q);
+			for (const auto& c : components)
+				n += EstimateMemoryBytes(c.vertices) + EstimateMemoryBytes(c.dist) + EstimateMemoryBytes(c.next);
+			return n;
+		}
+
+		void DistanceOracle::Push(int d, int i)
+		{
+			q.push_back(static_cast<std::uint64_t>(d) << 32 | i);
+			std::push_heap(q.begin(), q.end(), std::greater<std::uint64_t>());
+		}
+
+	} // namespace Internal
+} // namespace QDPF
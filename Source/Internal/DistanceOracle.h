@@ -0,0 +1,282 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#ifndef QDPF_INTERNAL_DISTANCE_ORACLE_HPP
+#define QDPF_INTERNAL_DISTANCE_ORACLE_HPP
+
+#include <algorithm>  // for std::push_heap, std::pop_heap
+#include <cstddef>	  // for std::size_t
+#include <cstdint>	  // for std::uint64_t
+#include <functional> // for std::greater
+#include <utility>	  // for std::pair, std::move
+#include <vector>	  // for std::vector
+
+#include "Base.h"
+
+// DistanceOracle
+// ~~~~~~~~~~~~~~
+// All-pairs shortest distances and next hops on a small symmetric graph.
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		// DistanceOracle keeps the exact distances between all pairs of vertices of a symmetric graph
+		// (the edge u->v exists along with v->u of the same cost), on dense vertices in range [0, n),
+		// along with the next vertex on a shortest path. A query is then a table lookup, and a path is
+		// a walk on the next hops.
+		//
+		// The tables are kept per connected component, there are no entries between two components.
+		// A component of more than maxSize vertices has no tables, the memory of a component of size c
+		// is 2 * c * c ints. Computing them takes a dijkstra search from each vertex, so a change of the
+		// graph drops the tables of the changed components only, and they are computed again on the
+		// next ComputeDropped call.
+		//
+		// The graph is given by two callables:
+		// 1. isVertex: bool(int v), returns true if the index v is in use.
+		// 2. neighbours: void(int u, Visitor& visitor), visits the neighbours of u, the visitor is a
+		//    callable void(int v, int cost).
+		class DistanceOracle
+		{
+		public:
+			// Labels the connected components of the graph of n vertices, and computes the tables of the
+			// components of at most maxSize vertices.
+			template <typename IsVertexF, typename NeighboursF>
+			void Build(int maxSize, int n, IsVertexF&& isVertex, NeighboursF&& neighbours);
+
+			// Labels the components again after the graph is changed, to n vertices. The touched
+			// vertices are the same as Landmarks::Repair's (duplicates are ok):
+			// 1. the vertices added or removed, and the neighbours of the removed ones.
+			// 2. at least one end of each new edge.
+			// The tables of the components with touched vertices are dropped, the others are kept.
+			template <typename IsVertexF, typename NeighboursF>
+			void Repair(int n, const std::vector<int>& touched, IsVertexF&& isVertex,
+				NeighboursF&& neighbours);
+
+			// Computes the tables dropped by Repair, of the components of at most maxSize vertices.
+			template <typename NeighboursF>
+			void ComputeDropped(NeighboursF&& neighbours);
+
+			// Returns the upper bound (exclusive) of the vertices.
+			int N() const { return n; }
+
+			// Returns true if vertex u and v are in the same connected component.
+			bool Reachable(int u, int v) const { return componentOf[u] == componentOf[v]; }
+
+			// Returns true if the distance between u and v is known: they are unreachable, or their
+			// component has the tables.
+			// The reachability is always known, even if the tables are dropped.
+			bool Covers(int u, int v) const
+			{
+				return !Reachable(u, v) || !components[componentOf[u]].dist.empty();
+			}
+
+			// Returns the distance between u and v, inf for unreachable. Covers(u,v) must be true.
+			int Distance(int u, int v) const
+			{
+				if (!Reachable(u, v))
+					return inf;
+				const auto& c = components[componentOf[u]];
+				return c.dist[Entry(c, u, v)];
+			}
+
+			// Returns the vertex next to u on a shortest path from u to v, u itself if u is v.
+			// Covers(u,v) and Reachable(u,v) must be true.
+			int NextHop(int u, int v) const
+			{
+				const auto& c = components[componentOf[u]];
+				return c.next[Entry(c, u, v)];
+			}
+
+			// Returns the number of distances stored.
+			std::size_t NumEntries() const;
+
+			// Returns the estimated heap bytes.
+			std::size_t MemoryBytes() const;
+
+		private:
+			struct Component
+			{
+				// the vertices of the component, by local indexes.
+				std::vector<int> vertices;
+				// dist[i * size + j] is the distance between the vertices of local index i and j, and
+				// next[i * size + j] is the vertex next to i on the way. Empty if the component is larger
+				// than maxSize, or the tables are dropped.
+				std::vector<int> dist, next;
+			};
+
+			int maxSize = 0, n = 0;
+			// componentOf[v] is the component of vertex v, -1 for none. localIndex[v] is the index of v
+			// in its component.
+			std::vector<int>	   componentOf, localIndex;
+			std::vector<Component> components;
+
+			// ~~~~~~ buffers, kept across calls ~~~~~~
+			// touched[v] is 1 if vertex v is touched since the last update.
+			std::vector<char> touched;
+			// the edges of the component computing, { local index, cost } of local vertex i are
+			// edges[offsets[i]..offsets[i+1]).
+			std::vector<int>				 offsets;
+			std::vector<std::pair<int, int>> edges;
+			// the smallest-first binary heap of distance << 32 | local index.
+			std::vector<std::uint64_t> q;
+
+			std::size_t Entry(const Component& c, int u, int v) const
+			{
+				return static_cast<std::size_t>(localIndex[u]) * c.vertices.size() + localIndex[v];
+			}
+			template <typename IsVertexF, typename NeighboursF>
+			void Label(int n, IsVertexF&& isVertex, NeighboursF&& neighbours);
+			template <typename NeighboursF>
+			void Compute(Component& c, NeighboursF&& neighbours);
+			void Push(int d, int i);
+		};
+
+		//////////////////////////////////////////
+		/// Implementation for Templated Functions
+		//////////////////////////////////////////
+
+		template <typename IsVertexF, typename NeighboursF>
+		void DistanceOracle::Build(int maxSize, int n, IsVertexF&& isVertex, NeighboursF&& neighbours)
+		{
+			this->maxSize = maxSize;
+			componentOf.clear(), components.clear();
+			touched.assign(n, 1);
+			Label(n, isVertex, neighbours);
+			ComputeDropped(neighbours);
+		}
+
+		template <typename IsVertexF, typename NeighboursF>
+		void DistanceOracle::Repair(int n, const std::vector<int>& touched, IsVertexF&& isVertex,
+			NeighboursF&& neighbours)
+		{
+			if (touched.empty())
+				return;
+			this->touched.assign(n, 0);
+			for (auto v : touched)
+				this->touched[v] = 1;
+			Label(n, isVertex, neighbours);
+		}
+
+		template <typename NeighboursF>
+		void DistanceOracle::ComputeDropped(NeighboursF&& neighbours)
+		{
+			for (auto& c : components)
+			{
+				if (c.dist.empty() && c.vertices.size() <= maxSize)
+					Compute(c, neighbours);
+			}
+		}
+
+		// Labels the components again, the tables of an untouched component are taken from the old one.
+		template <typename IsVertexF, typename NeighboursF>
+		void DistanceOracle::Label(int n, IsVertexF&& isVertex, NeighboursF&& neighbours)
+		{
+			std::vector<int>	   oldComponentOf;
+			std::vector<Component> olds;
+			oldComponentOf.swap(componentOf), olds.swap(components);
+
+			this->n = n;
+			componentOf.assign(n, -1);
+			localIndex.resize(n);
+
+			for (int s = 0; s < n; ++s)
+			{
+				if (componentOf[s] != -1 || !isVertex(s))
+					continue;
+				int c = components.size();
+				components.emplace_back();
+
+				// breadth first search from s.
+				std::vector<int> vertices{ s };
+				bool			 anyTouched = touched[s];
+				componentOf[s] = c;
+				auto visit = [this, c, &vertices, &anyTouched](int v, int cost) {
+					if (componentOf[v] != -1)
+						return;
+					componentOf[v] = c;
+					anyTouched = anyTouched || touched[v];
+					vertices.push_back(v);
+				};
+				for (int k = 0; k < vertices.size(); ++k)
+					neighbours(vertices[k], visit);
+
+				// an untouched component has the same vertices and edges as before, so is the old
+				// component of its vertices.
+				int old = anyTouched || s >= oldComponentOf.size() ? -1 : oldComponentOf[s];
+				if (old != -1 && olds[old].vertices.size() == vertices.size())
+				{
+					for (auto v : vertices)
+					{
+						if (v >= oldComponentOf.size() || oldComponentOf[v] != old)
+						{
+							old = -1;
+							break;
+						}
+					}
+				}
+				else
+					old = -1;
+
+				auto& component = components[c];
+				if (old != -1)
+					component = std::move(olds[old]);
+				else
+					component.vertices = std::move(vertices);
+				for (int k = 0; k < component.vertices.size(); ++k)
+					localIndex[component.vertices[k]] = k;
+			}
+		}
+
+		// Computes the tables of a component, by a dijkstra search from each of its vertices.
+		template <typename NeighboursF>
+		void DistanceOracle::Compute(Component& c, NeighboursF&& neighbours)
+		{
+			int size = c.vertices.size();
+
+			// copies the edges by local indexes.
+			offsets.assign(size + 1, 0);
+			edges.clear();
+			auto collect = [this](int v, int cost) { edges.push_back({ localIndex[v], cost }); };
+			for (int i = 0; i < size; ++i)
+			{
+				neighbours(c.vertices[i], collect);
+				offsets[i + 1] = edges.size();
+			}
+
+			std::size_t size2 = static_cast<std::size_t>(size) * size;
+			c.dist.assign(size2, inf);
+			c.next.assign(size2, -1);
+			for (int s = 0; s < size; ++s)
+			{
+				int* dist = &c.dist[static_cast<std::size_t>(s) * size];
+				int* next = &c.next[static_cast<std::size_t>(s) * size];
+				dist[s] = 0, next[s] = c.vertices[s];
+				Push(0, s);
+				while (!q.empty())
+				{
+					std::pop_heap(q.begin(), q.end(), std::greater<std::uint64_t>());
+					int d = q.back() >> 32, u = q.back() & 0xffffffff;
+					q.pop_back();
+					if (d > dist[u])
+						continue; // stale
+					for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+					{
+						auto [v, cost] = edges[k];
+						if (d + cost < dist[v])
+						{
+							dist[v] = d + cost;
+							// the next hop of the start's neighbours is themselves, the others inherit it.
+							next[v] = u == s ? c.vertices[v] : next[u];
+							Push(dist[v], v);
+						}
+					}
+				}
+			}
+		}
+
+	} // namespace Internal
+} // namespace QDPF
+
+#endif
@@ -68,5 +68,23 @@ namespace QDPF
 			}
 		}
 
+		std::size_t SimpleDirectedGraph::NumEdges() const
+		{
+			std::size_t n = 0;
+			for (auto& m : edges)
+				n += m.size();
+			return n;
+		}
+
+		std::size_t SimpleDirectedGraph::MemoryBytes() const
+		{
+			std::size_t n = EstimateMemoryBytes(edges) + EstimateMemoryBytes(predecessors);
+			for (auto& m : edges)
+				n += EstimateMemoryBytes(m);
+			for (auto& st : predecessors)
+				n += EstimateMemoryBytes(st);
+			return n;
+		}
+
 	} // namespace Internal
 } // namespace QDPF
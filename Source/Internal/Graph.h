@@ -5,9 +5,12 @@
 #define QDPF_INTERNAL_GRAPH_HPP
 
 #include <functional> // for std::function
+#include <vector>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "Base.h"
+
 // Graph
 // ~~~~~~
 // Directed graph abstraction.
@@ -55,6 +58,12 @@ namespace QDPF
 
 			// Iterates each vertex of the graph.
 			virtual void ForEachEdge(EdgeVisitor<Vertex>& visitor) const = 0;
+
+			// Returns the number of edges.
+			virtual std::size_t NumEdges() const = 0;
+
+			// Returns the estimated heap bytes of the graph.
+			virtual std::size_t MemoryBytes() const = 0;
 		};
 
 		// SimpleDirectedGraph is a simple implementation of IDirectedGraph, using integral vertex.
@@ -73,6 +82,9 @@ namespace QDPF
 			void Clear() override;
 			void ForEachEdge(EdgeVisitor<int>& visitor) const override;
 
+			std::size_t NumEdges() const override;
+			std::size_t MemoryBytes() const override;
+
 		protected:
 			// edges[from] => { to => cost }
 			std::vector<std::unordered_map<int, int>> edges;
@@ -80,6 +92,138 @@ namespace QDPF
 			std::vector<std::unordered_set<int>> predecessors;
 		};
 
+		// SparseDirectedGraph is an implementation of IDirectedGraph for sparse vertices, e.g. the gate
+		// cells of a large grid map, or the leaf nodes of a quadtree.
+		// Only added vertices are stored: each vertex is mapped to a stable dense index, and the edges of
+		// a dense index are stored in small contiguous arrays. The dense index of a removed vertex is
+		// recycled by a free list, so they are always small, searches can store states in flat arrays
+		// indexed by them.
+		// AddEdge adds the vertices implicitly, and ClearEdgeFrom/ClearEdgeTo keep the vertices, a vertex
+		// is removed only by RemoveVertex.
+		// Note that AddEdge doesn't check duplicates, the caller should make sure that the edge doesn't
+		// exist already (see HasEdge).
+		// NullVertex is returned by VertexAt for recycled dense indexes.
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher = std::hash<Vertex>>
+		class SparseDirectedGraph : public IDirectedGraph<Vertex>
+		{
+		public:
+			// ~~~~~~~~~~ Implements IDirectedGraph ~~~~~~~~~~~~~~~~
+			void Init() override;
+			void AddEdge(Vertex u, Vertex v, int cost) override;
+			void RemoveEdge(Vertex u, Vertex v) override;
+			void ClearEdgeFrom(Vertex u) override;
+			void ClearEdgeTo(Vertex v) override;
+			void ForEachNeighbours(Vertex u, NeighbourVertexVisitor<Vertex>& visitor) const override;
+			void Clear() override;
+			void ForEachEdge(EdgeVisitor<Vertex>& visitor) const override;
+
+			std::size_t NumEdges() const override { return numEdges; }
+			std::size_t MemoryBytes() const override;
+
+			// Returns true if the edge from vertex u to v exists.
+			// It scans the edges from u, which is fine for vertices of small out-degree.
+			bool HasEdge(Vertex u, Vertex v) const;
+
+			// ~~~~~~~~~~ Vertices and dense indexes ~~~~~~~~~~~~~~~~
+
+			// Adds vertex u if not exist, returns its dense index.
+			int AddVertex(Vertex u);
+
+			// Removes vertex u and all edges connecting with it, its dense index is recycled.
+			// Does nothing if u doesn't exist.
+			void RemoveVertex(Vertex u);
+
+			// Returns the dense index of vertex u, -1 if not exist.
+			int IndexOf(Vertex u) const;
+
+			// Returns the vertex of dense index i, NullVertex if i is recycled.
+			Vertex VertexAt(int i) const { return vertices[i]; }
+
+			// Returns the upper bound (exclusive) of dense indexes.
+			int NumIndexes() const { return vertices.size(); }
+
+			// Returns the number of vertices.
+			std::size_t NumVertices() const { return indexes.size(); }
+
+			// Call given visitor function with the dense index of each neighbor vertex, connecting from
+			// the vertex of dense index i.
+			// The visitor is any callable of signature void(int j, int cost), so it can be inlined.
+			template <typename Visitor>
+			void ForEachNeighbourIndexes(int i, Visitor&& visitor) const
+			{
+				for (const auto& e : edges[i])
+					visitor(e.to, e.cost);
+			}
+
+		protected:
+			// Edge to dense index `to`, rpos is its position in predecessors[to].
+			struct Edge
+			{
+				int to, cost, rpos;
+			};
+			// Predecessor dense index `from`, pos is the position of the edge in edges[from].
+			struct Predecessor
+			{
+				int from, pos;
+			};
+
+			// vertex => dense index.
+			std::unordered_map<Vertex, int, VertexHasher> indexes;
+			// dense index => vertex, NullVertex for recycled indexes.
+			std::vector<Vertex> vertices;
+			// edges[i] => [ edge from vertex i .. ]
+			std::vector<std::vector<Edge>> edges;
+			// predecessors[i] => [ predecessor of vertex i .. ]
+			std::vector<std::vector<Predecessor>> predecessors;
+			// recycled dense indexes.
+			std::vector<int> freeIndexes;
+			std::size_t		 numEdges = 0;
+
+			// Removes the pos-th edge from dense index i.
+			void RemoveEdgeAt(int i, int pos);
+		};
+
+		// FrozenDirectedGraph is an immutable copy of a SparseDirectedGraph on its dense indexes, in the
+		// compressed sparse row (CSR) layout: the edges from dense index i are stored contiguously at
+		// edges[offsets[i]..offsets[i+1]). It's rebuilt as a whole by Build.
+		class FrozenDirectedGraph
+		{
+		public:
+			// Rebuilds from given graph g, the dense indexes of g are kept.
+			template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+			void Build(const SparseDirectedGraph<Vertex, NullVertex, VertexHasher>& g);
+
+			// Call given visitor function with the dense index of each neighbor vertex, connecting from
+			// dense index i.
+			// The visitor is any callable of signature void(int j, int cost).
+			template <typename Visitor>
+			void ForEachNeighbourIndexes(int i, Visitor&& visitor) const
+			{
+				for (int k = offsets[i]; k < offsets[i + 1]; ++k)
+					visitor(edges[k].to, edges[k].cost);
+			}
+
+			// Returns the upper bound (exclusive) of dense indexes.
+			int NumIndexes() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+			// Returns the number of edges.
+			std::size_t NumEdges() const { return edges.size(); }
+
+			// Returns the estimated heap bytes of the graph.
+			std::size_t MemoryBytes() const
+			{
+				return EstimateMemoryBytes(offsets) + EstimateMemoryBytes(edges);
+			}
+
+		protected:
+			struct Edge
+			{
+				int to, cost;
+			};
+			std::vector<int>  offsets;
+			std::vector<Edge> edges;
+		};
+
 		// SimpleUnorderedMapDirectedGraph is a simple directed graph storing in an unordered_map.
 		// This uses less memory than SimpleDirectedGraph for sparse graph.
 		template <typename Vertex, typename VertexHasher = std::hash<Vertex>>
@@ -95,6 +239,9 @@ namespace QDPF
 			void Clear() override;
 			void ForEachEdge(EdgeVisitor<Vertex>& visitor) const override;
 
+			std::size_t NumEdges() const override;
+			std::size_t MemoryBytes() const override;
+
 		protected:
 			using M = std::unordered_map<Vertex, int, VertexHasher>;
 			using ST = std::unordered_set<Vertex, VertexHasher>;
@@ -227,6 +374,231 @@ namespace QDPF
 			}
 		}
 
+		template <typename Vertex, typename VertexHasher>
+		std::size_t SimpleUnorderedMapDirectedGraph<Vertex, VertexHasher>::NumEdges() const
+		{
+			std::size_t n = 0;
+			for (auto& [u, m] : edges)
+				n += m.size();
+			return n;
+		}
+
+		template <typename Vertex, typename VertexHasher>
+		std::size_t SimpleUnorderedMapDirectedGraph<Vertex, VertexHasher>::MemoryBytes() const
+		{
+			std::size_t n = EstimateMemoryBytes(edges) + EstimateMemoryBytes(predecessors);
+			for (auto& [u, m] : edges)
+				n += EstimateMemoryBytes(m);
+			for (auto& [v, st] : predecessors)
+				n += EstimateMemoryBytes(st);
+			return n;
+		}
+
+		// ~~~~~~~~~~~ Implements SparseDirectedGraph ~~~~~~~~~~~~~~
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::Init() {}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		int SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::IndexOf(Vertex u) const
+		{
+			auto it = indexes.find(u);
+			return it == indexes.end() ? -1 : it->second;
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		int SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::AddVertex(Vertex u)
+		{
+			auto [it, inserted] = indexes.try_emplace(u, 0);
+			if (!inserted)
+				return it->second;
+			int i;
+			if (!freeIndexes.empty())
+			{
+				i = freeIndexes.back();
+				freeIndexes.pop_back();
+				vertices[i] = u;
+			}
+			else
+			{
+				i = vertices.size();
+				vertices.push_back(u);
+				edges.emplace_back();
+				predecessors.emplace_back();
+			}
+			it->second = i;
+			return i;
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::RemoveVertex(Vertex u)
+		{
+			int i = IndexOf(u);
+			if (i == -1)
+				return;
+			ClearEdgeFrom(u);
+			ClearEdgeTo(u);
+			indexes.erase(u);
+			vertices[i] = NullVertex;
+			freeIndexes.push_back(i);
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::RemoveEdgeAt(int i, int pos)
+		{
+			auto& es = edges[i];
+			auto  e = es[pos];
+
+			// removes the predecessor record of this edge, moves the last one to its position.
+			auto& ps = predecessors[e.to];
+			if (e.rpos != ps.size() - 1)
+			{
+				auto p = ps.back();
+				ps[e.rpos] = p;
+				edges[p.from][p.pos].rpos = e.rpos;
+			}
+			ps.pop_back();
+
+			// removes the edge, moves the last one to its position.
+			if (pos != es.size() - 1)
+			{
+				auto last = es.back();
+				es[pos] = last;
+				predecessors[last.to][last.rpos].pos = pos;
+			}
+			es.pop_back();
+			--numEdges;
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::AddEdge(Vertex u, Vertex v, int cost)
+		{
+			int i = AddVertex(u), j = AddVertex(v);
+			edges[i].push_back({ j, cost, static_cast<int>(predecessors[j].size()) });
+			predecessors[j].push_back({ i, static_cast<int>(edges[i].size()) - 1 });
+			++numEdges;
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::RemoveEdge(Vertex u, Vertex v)
+		{
+			int i = IndexOf(u), j = IndexOf(v);
+			if (i == -1 || j == -1)
+				return;
+			auto& es = edges[i];
+			for (int pos = 0; pos < es.size(); ++pos)
+			{
+				if (es[pos].to == j)
+				{
+					RemoveEdgeAt(i, pos);
+					return;
+				}
+			}
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::ClearEdgeFrom(Vertex u)
+		{
+			int i = IndexOf(u);
+			if (i == -1)
+				return;
+			// removes from the back, no edges are moved.
+			while (!edges[i].empty())
+				RemoveEdgeAt(i, edges[i].size() - 1);
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::ClearEdgeTo(Vertex v)
+		{
+			int j = IndexOf(v);
+			if (j == -1)
+				return;
+			while (!predecessors[j].empty())
+			{
+				auto p = predecessors[j].back();
+				RemoveEdgeAt(p.from, p.pos);
+			}
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::ForEachNeighbours(
+			Vertex u, NeighbourVertexVisitor<Vertex>& visitor) const
+		{
+			int i = IndexOf(u);
+			if (i == -1)
+				return;
+			for (const auto& e : edges[i])
+				visitor(vertices[e.to], e.cost);
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::Clear()
+		{
+			indexes.clear();
+			vertices.clear();
+			edges.clear();
+			predecessors.clear();
+			freeIndexes.clear();
+			numEdges = 0;
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::ForEachEdge(
+			EdgeVisitor<Vertex>& visitor) const
+		{
+			for (int i = 0; i < vertices.size(); ++i)
+			{
+				if (vertices[i] == NullVertex)
+					continue;
+				for (const auto& e : edges[i])
+					visitor(vertices[i], vertices[e.to], e.cost);
+			}
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		std::size_t SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::MemoryBytes() const
+		{
+			std::size_t n = EstimateMemoryBytes(indexes) + EstimateMemoryBytes(vertices)
+				+ EstimateMemoryBytes(edges) + EstimateMemoryBytes(predecessors)
+				+ EstimateMemoryBytes(freeIndexes);
+			for (auto& es : edges)
+				n += EstimateMemoryBytes(es);
+			for (auto& ps : predecessors)
+				n += EstimateMemoryBytes(ps);
+			return n;
+		}
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		bool SparseDirectedGraph<Vertex, NullVertex, VertexHasher>::HasEdge(Vertex u, Vertex v) const
+		{
+			int i = IndexOf(u), j = IndexOf(v);
+			if (i == -1 || j == -1)
+				return false;
+			for (const auto& e : edges[i])
+			{
+				if (e.to == j)
+					return true;
+			}
+			return false;
+		}
+
+		// ~~~~~~~~~~~ Implements FrozenDirectedGraph ~~~~~~~~~~~~~~
+
+		template <typename Vertex, Vertex NullVertex, typename VertexHasher>
+		void FrozenDirectedGraph::Build(const SparseDirectedGraph<Vertex, NullVertex, VertexHasher>& g)
+		{
+			int n = g.NumIndexes();
+			offsets.assign(n + 1, 0);
+			edges.clear();
+			edges.reserve(g.NumEdges());
+			for (int i = 0; i < n; ++i)
+			{
+				// recycled indexes have no edges.
+				g.ForEachNeighbourIndexes(i, [this](int j, int cost) { edges.push_back({ j, cost }); });
+				offsets[i + 1] = edges.size();
+			}
+		}
+
 	} // namespace Internal
 } // namespace QDPF
 #endif
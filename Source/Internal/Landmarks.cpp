@@ -0,0 +1,72 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "Landmarks.h"
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		int Landmarks::LowerBound(const int* a, const int* b, int k)
+		{
+			int h = 0;
+			for (int i = 0; i < k; ++i)
+			{
+				// a landmark that doesn't reach both tells nothing.
+				if (a[i] == inf || b[i] == inf)
+					continue;
+				h = std::max(h, a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+			}
+			return h;
+		}
+
+		std::size_t Landmarks::MemoryBytes() const
+		{
+			return EstimateMemoryBytes(roots) + EstimateMemoryBytes(dist) + EstimateMemoryBytes(parent)
+				+ EstimateMemoryBytes(q) + EstimateMemoryBytes(status) + EstimateMemoryBytes(affected);
+		}
+
+		// Grows the tables to n vertices, the new ones are unreachable.
+		void Landmarks::Resize(int n)
+		{
+			if (n <= this->n)
+				return;
+			this->n = n;
+			dist.resize(static_cast<std::size_t>(n) * k, inf);
+			parent.resize(static_cast<std::size_t>(n) * k, -1);
+		}
+
+		void Landmarks::Push(int d, int v)
+		{
+			q.push_back({ d, v });
+			std::push_heap(q.begin(), q.end(), std::greater<std::pair<int, int>>());
+		}
+
+		void Landmarks::ClearLandmark(int i)
+		{
+			for (int v = 0; v < n; ++v)
+				Dist(v, i) = inf, Parent(v, i) = -1;
+		}
+
+		// Returns the vertex of which the distance to the nearest landmark (except the landmark skip) is
+		// the largest, among the vertices reached. Returns -1 if no landmark reaches any vertex.
+		int Landmarks::PickFarthest(int skip)
+		{
+			int best = -1, bestDist = -1;
+			for (int v = 0; v < n; ++v)
+			{
+				int d = inf;
+				for (int i = 0; i < k; ++i)
+				{
+					if (i != skip && roots[i] != -1 && Dist(v, i) != inf)
+						d = std::min(d, Dist(v, i));
+				}
+				if (d != inf && d > bestDist)
+					best = v, bestDist = d;
+			}
+			return best;
+		}
+
+	} // namespace Internal
+} // namespace QDPF
@@ -0,0 +1,291 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#ifndef QDPF_INTERNAL_LANDMARKS_HPP
+#define QDPF_INTERNAL_LANDMARKS_HPP
+
+#include <algorithm>  // for std::push_heap, std::pop_heap, std::max, std::min
+#include <cstddef>	  // for std::size_t
+#include <functional> // for std::greater
+#include <utility>	  // for std::pair
+#include <vector>	  // for std::vector
+
+#include "Base.h"
+
+// Landmarks
+// ~~~~~~~~~
+// ALT (A*, Landmarks and Triangle inequality) heuristics on a symmetric graph.
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		// Landmarks keeps the exact distances from a few landmark vertices to all vertices of a
+		// symmetric graph (the edge u->v exists along with v->u of the same cost), on dense vertices in
+		// range [0, n). By the triangle inequality, the distance between u and v is at least
+		// |d(L,u) - d(L,v)| for each landmark L, which is a consistent heuristic for A*, and much
+		// tighter than the straight distance on maps with many walls.
+		//
+		// The graph is given by two callables:
+		// 1. isVertex: bool(int v), returns true if the index v is in use.
+		// 2. neighbours: void(int u, Visitor& visitor), visits the neighbours of u, the visitor is a
+		//    callable void(int v, int cost).
+		class Landmarks
+		{
+		public:
+			// Picks k landmarks on the graph of n vertices, and computes the distances from them.
+			// The landmarks are picked one by one, each is the farthest vertex from the picked ones, so
+			// they spread around the borders of the graph.
+			template <typename IsVertexF, typename NeighboursF>
+			void Build(int k, int n, IsVertexF&& isVertex, NeighboursF&& neighbours);
+
+			// Repairs the distances after the graph is changed, to n vertices. The touched vertices are
+			// (duplicates are ok):
+			// 1. the vertices added or removed, and the neighbours of the removed ones.
+			// 2. at least one end of each new edge.
+			// Only the distances affected by the changes are computed again. A landmark touched is
+			// picked again.
+			template <typename IsVertexF, typename NeighboursF>
+			void Repair(int n, const std::vector<int>& touched, IsVertexF&& isVertex,
+				NeighboursF&& neighbours);
+
+			// Returns the number of landmarks.
+			int K() const { return k; }
+
+			// Returns the upper bound (exclusive) of the vertices.
+			int N() const { return n; }
+
+			// Returns the distances from each landmark to vertex v, K() of them, inf for unreachable.
+			const int* DistancesOf(int v) const { return &dist[static_cast<std::size_t>(v) * k]; }
+
+			// Returns the lower bound of the distance between two vertices, of which the distances from
+			// the landmarks are a and b (see DistancesOf).
+			// Returns 0 if they are not reached by any landmark together.
+			static int LowerBound(const int* a, const int* b, int k);
+
+			// Returns the number of distances stored.
+			std::size_t NumEntries() const { return dist.size(); }
+
+			// Returns the estimated heap bytes.
+			std::size_t MemoryBytes() const;
+
+		private:
+			int k = 0, n = 0;
+			// the landmark vertices, -1 for none.
+			std::vector<int> roots;
+			// dist[v * k + i] is the distance from landmark i to vertex v.
+			std::vector<int> dist;
+			// parent[v * k + i] is the previous vertex of v on the shortest path from landmark i.
+			std::vector<int> parent;
+
+			// ~~~~~~ buffers, kept across calls ~~~~~~
+			// the smallest-first binary heap of { distance, vertex }.
+			std::vector<std::pair<int, int>> q;
+			// status of each vertex and the affected vertices on repairing, see Repair.
+			std::vector<char> status;
+			std::vector<int>  affected;
+
+			int&  Dist(int v, int i) { return dist[static_cast<std::size_t>(v) * k + i]; }
+			int&  Parent(int v, int i) { return parent[static_cast<std::size_t>(v) * k + i]; }
+			void  Resize(int n);
+			void  Push(int d, int v);
+			void  ClearLandmark(int i);
+			int	  PickFarthest(int skip);
+			template <typename IsVertexF, typename NeighboursF>
+			int PickRoot(int i, IsVertexF&& isVertex, NeighboursF&& neighbours);
+			template <typename NeighboursF>
+			void Compute(int i, NeighboursF&& neighbours);
+		};
+
+		//////////////////////////////////////////
+		/// Implementation for Templated Functions
+		//////////////////////////////////////////
+
+		template <typename IsVertexF, typename NeighboursF>
+		void Landmarks::Build(int k, int n, IsVertexF&& isVertex, NeighboursF&& neighbours)
+		{
+			this->k = k, this->n = 0;
+			dist.clear(), parent.clear();
+			roots.assign(k, -1);
+			Resize(n);
+			for (int i = 0; i < k; ++i)
+			{
+				roots[i] = PickRoot(i, isVertex, neighbours);
+				Compute(i, neighbours);
+			}
+		}
+
+		// Picks the root of landmark i: the farthest vertex from the other landmarks.
+		// The first one is the farthest vertex from an arbitrary vertex.
+		template <typename IsVertexF, typename NeighboursF>
+		int Landmarks::PickRoot(int i, IsVertexF&& isVertex, NeighboursF&& neighbours)
+		{
+			int root = PickFarthest(i);
+			if (root != -1)
+				return root;
+			// no other landmarks reach any vertex, starts from the first vertex.
+			for (int v = 0; v < n && root == -1; ++v)
+			{
+				if (isVertex(v))
+					root = v;
+			}
+			if (root == -1)
+				return -1;
+			roots[i] = root;
+			Compute(i, neighbours);
+			return PickFarthest(-1);
+		}
+
+		// Computes the distances from landmark i by dijkstra, from the vertices queued (the root if the
+		// queue is empty). The distances of the queued vertices are upper bounds, the others are either
+		// exact or inf.
+		template <typename NeighboursF>
+		void Landmarks::Compute(int i, NeighboursF&& neighbours)
+		{
+			if (q.empty())
+			{
+				ClearLandmark(i);
+				if (roots[i] == -1)
+					return;
+				Dist(roots[i], i) = 0;
+				Push(0, roots[i]);
+			}
+
+			int	 u;
+			auto relax = [this, i, &u](int v, int cost) {
+				int d = Dist(u, i) + cost;
+				if (d < Dist(v, i))
+				{
+					Dist(v, i) = d;
+					Parent(v, i) = u;
+					Push(d, v);
+				}
+			};
+
+			while (!q.empty())
+			{
+				std::pop_heap(q.begin(), q.end(), std::greater<std::pair<int, int>>());
+				auto [d, v] = q.back();
+				q.pop_back();
+				if (d > Dist(v, i))
+					continue; // stale
+				u = v;
+				neighbours(u, relax);
+			}
+		}
+
+		// Repairs landmark by landmark, in two steps (the idea of Ramalingam and Reps's dynamic shortest
+		// paths):
+		// 1. Finds the affected vertices, whose distances don't hold any more. Starting from the touched
+		//    vertices, in the order of the old distances, a vertex keeps its distance if an unaffected
+		//    neighbour still gives the same distance, otherwise it's affected, and so are its children
+		//    to check on the shortest path tree. On grid maps most vertices have many shortest paths, so
+		//    few are affected.
+		// 2. Computes the affected vertices again, starting from the best distances through their
+		//    unaffected neighbours, along with the touched vertices which may give shorter ways.
+		template <typename IsVertexF, typename NeighboursF>
+		void Landmarks::Repair(int n, const std::vector<int>& touched, IsVertexF&& isVertex,
+			NeighboursF&& neighbours)
+		{
+			if (k == 0 || touched.empty())
+				return;
+			Resize(n);
+
+			// status of a vertex: 0: unaffected, 1: to check, 2: affected.
+			std::vector<int> repicks;
+			for (int i = 0; i < k; ++i)
+			{
+				int root = roots[i];
+				status.assign(n, 0);
+				for (auto v : touched)
+					status[v] = 1;
+				if (root == -1 || status[root] == 1)
+				{
+					repicks.push_back(i);
+					continue;
+				}
+
+				// step 1: finds the affected vertices.
+				for (auto v : touched)
+					Push(Dist(v, i), v);
+				affected.clear();
+				int	 v;
+				bool held;
+				auto hold = [this, i, &v, &held](int u, int cost) {
+					if (!held && status[u] == 0 && Dist(u, i) < Dist(v, i) && Dist(u, i) + cost == Dist(v, i))
+						held = true, Parent(v, i) = u;
+				};
+				auto check = [this, i, &v](int w, int cost) {
+					if (status[w] == 0 && Parent(w, i) == v)
+						status[w] = 1, Push(Dist(w, i), w);
+				};
+				while (!q.empty())
+				{
+					std::pop_heap(q.begin(), q.end(), std::greater<std::pair<int, int>>());
+					v = q.back().second;
+					q.pop_back();
+					if (status[v] != 1)
+						continue; // duplicates
+					held = false;
+					// an unreachable vertex touched may be reachable now, computes it again as well.
+					if (isVertex(v) && Dist(v, i) != inf)
+						neighbours(v, hold);
+					if (held)
+					{
+						status[v] = 0;
+						continue;
+					}
+					status[v] = 2;
+					affected.push_back(v);
+					// the children of a removed vertex are touched already.
+					if (isVertex(v))
+						neighbours(v, check);
+				}
+
+				// step 2: computes the affected vertices again.
+				for (auto v : affected)
+					Dist(v, i) = inf, Parent(v, i) = -1;
+				auto seed = [this, i, &v](int u, int cost) {
+					if (status[u] == 0 && Dist(u, i) != inf && Dist(u, i) + cost < Dist(v, i))
+						Dist(v, i) = Dist(u, i) + cost, Parent(v, i) = u;
+				};
+				for (auto u : affected)
+				{
+					v = u;
+					if (!isVertex(v))
+						continue;
+					neighbours(v, seed);
+					if (Dist(v, i) != inf)
+						Push(Dist(v, i), v);
+				}
+				// the unaffected touched vertices may have new edges, they may go shorter through them, and
+				// so may their neighbours through them.
+				for (auto u : touched)
+				{
+					v = u;
+					if (status[v] != 0 || !isVertex(v))
+						continue;
+					neighbours(v, seed);
+					if (Dist(v, i) != inf)
+						Push(Dist(v, i), v);
+				}
+				// the queue may be empty if nothing reachable to repair.
+				if (!q.empty())
+					Compute(i, neighbours);
+			}
+
+			// the landmarks touched are picked again, after the others are repaired.
+			for (auto i : repicks)
+			{
+				roots[i] = -1;
+				ClearLandmark(i);
+				roots[i] = PickRoot(i, isVertex, neighbours);
+				Compute(i, neighbours);
+			}
+		}
+
+	} // namespace Internal
+} // namespace QDPF
+
+#endif
@@ -3,19 +3,28 @@
 
 #include "PathfinderAstar.h"
 
+#include <algorithm>
 #include <cassert>
-#include <unordered_set>
+#include <vector>
 
 namespace QDPF
 {
 	namespace Internal
 	{
 
-		void AStarPathFinderImpl::Reset(const QuadtreeMap* m, int x1, int y1, int x2, int y2)
+		void AStarPathFinderImpl::Reset(const QuadtreeMap* m, int x1, int y1, int x2, int y2,
+			PathfinderStats* stats)
 		{
+			QDPF_TRACE_SCOPE("AStarPathFinder::Reset");
+
 			// Debug mode, checks m, it's nullptr if mapx didn't find one.
 			assert(m != nullptr);
 
+			this->stats = stats;
+			if (stats != nullptr)
+				*stats = PathfinderStats{};
+			StageTimer timer(stats != nullptr ? &stats->ResetUs : nullptr);
+
 			// Resets the attributes.
 			this->x1 = x1, this->y1 = y1, this->x2 = x2, this->y2 = y2;
 			this->m = m;
@@ -49,10 +58,16 @@ namespace QDPF
 			// TODO: should we just stop the path finding on tihs case?
 			if (tNode == sNode && s != t && !sIsGate && !tIsGate)
 				ConnectCellsOnTmpGraph(s, t);
+
+			if (stats != nullptr)
+				stats->NumTmpEdges = tmp.NumEdges();
 		}
 
 		int AStarPathFinderImpl::ComputeNodeRoutes(NodePath& nodePath)
 		{
+			QDPF_TRACE_SCOPE("AStarPathFinder::ComputeNodeRoutes");
+			StageTimer timer(stats != nullptr ? &stats->NodeStageUs : nullptr);
+
 			nodePath.clear();
 
 			// any one of start and target are out of map bounds.
@@ -70,53 +85,183 @@ namespace QDPF
 				return 0;
 			}
 
+			// a node without id is not on the node graph, unreachable.
+			int sId = m->NodeId(sNode), tId = m->NodeId(tNode);
+			if (sId == -1 || tId == -1)
+				return -1;
+
+			return ComputeNodeRoutesBetween(sId, tId, &nodePath);
+		}
+
+		int AStarPathFinderImpl::ComputeNodeDistance(int x, int y)
+		{
+			QDPF_TRACE_SCOPE("AStarPathFinder::ComputeNodeDistance");
+
+			// any one of start and given cell are out of map bounds.
+			QdNode* node = m->FindNode(x, y);
+			if (sNode == nullptr || node == nullptr)
+				return -1;
+
+			// Can't route to or start from obstacles.
+			if (m->IsObstacle(x1, y1) || m->IsObstacle(x, y))
+				return -1;
+
+			// Same node.
+			if (sNode == node)
+				return 0;
+
+			// a node without id is not on the node graph, unreachable.
+			int sId = m->NodeId(sNode), id = m->NodeId(node);
+			if (sId == -1 || id == -1)
+				return -1;
+
+			return ComputeNodeRoutesBetween(sId, id, nullptr);
+		}
+
+		// Walks on the tables of the node distance oracle if the map has one covering the two nodes,
+		// otherwise searches on the node graph.
+		int AStarPathFinderImpl::ComputeNodeRoutesBetween(int sId, int tId, NodePath* nodePath)
+		{
+			auto oracle = m->NodeDistanceOracle();
+			if (oracle != nullptr && oracle->Covers(sId, tId))
+			{
+				int d = oracle->Distance(sId, tId);
+				if (d == inf)
+					return -1;
+				if (nodePath != nullptr)
+				{
+					for (int u = sId;; u = oracle->NextHop(u, tId))
+					{
+						nodePath->push_back({ m->NodeAt(u), oracle->Distance(sId, u) });
+						if (u == tId)
+							break;
+					}
+				}
+				return d;
+			}
+
 			// collector for path result.
-			A1::PathCollector collector = [this, &nodePath](QdNode* node, int cost) {
-				nodePath.push_back({ node, cost });
+			auto collector = [this, nodePath](int id, int cost) {
+				if (nodePath != nullptr)
+					nodePath->push_back({ m->NodeAt(id), cost });
 			};
 
-			// collector for neighbour qd nodes.
-			A1::NeighboursCollectorT neighborsCollector = [this](QdNode*					   u,
-															  NeighbourVertexVisitor<QdNode*>& visitor) {
-				m->ForEachNeighbourNodes(u, visitor);
+			// collector for neighbour node ids.
+			auto neighborsCollector = [this](int u, auto& visitor) {
+				m->ForEachNeighbourNodeIds(u, visitor);
 			};
 
-			// Distance function
-			A1::Distance distance = [this](QdNode* a, QdNode* b) {
-				return this->m->DistanceBetweenNodes(a, b);
+			// Distance function, tightened by the landmarks if there are.
+			auto distance = [this, landmarks1 = m->NodeLandmarks()](int a, int b) {
+				int d = this->m->DistanceBetweenNodes(m->NodeAt(a), m->NodeAt(b));
+				if (landmarks1 != nullptr)
+					d = std::max(d, Landmarks::LowerBound(landmarks1->DistancesOf(a),
+										landmarks1->DistancesOf(b), landmarks1->K()));
+				return d;
 			};
 
 			// compute
-			return astar1.Compute(sNode, tNode, collector, distance, neighborsCollector, nullptr);
+			return astar1.ComputeWith(sId, tId, collector, distance, neighborsCollector, nullptr,
+				stats != nullptr ? &stats->NodeSearch : nullptr, m->NumNodeIds());
+		}
+
+		// Resets the search indexes for the gate search, after the start and target are set.
+		void AStarPathFinderImpl::ResetSearchIndexes()
+		{
+			numGateCellIndexes = m->NumGateCellIndexes();
+			tmpCells.clear();
+			if (m->GateCellIndex(s) == -1)
+				tmpCells.push_back(s);
+			if (t != s && m->GateCellIndex(t) == -1)
+				tmpCells.push_back(t);
+		}
+
+		int AStarPathFinderImpl::SearchIndexOf(int u) const
+		{
+			int i = m->GateCellIndex(u);
+			if (i != -1)
+				return i;
+			for (int k = 0; k < tmpCells.size(); ++k)
+			{
+				if (tmpCells[k] == u)
+					return numGateCellIndexes + k;
+			}
+			return -1;
+		}
+
+		int AStarPathFinderImpl::CellOfSearchIndex(int i) const
+		{
+			return i < numGateCellIndexes ? m->GateCellAt(i) : tmpCells[i - numGateCellIndexes];
+		}
+
+		// Computes the landmark distances of the tmp cells, after the search indexes are reset.
+		// A tmp cell is connected only to the gate cells of its node (and the other tmp cell in the
+		// same node, which doesn't make a shorter way), so its distance from a landmark is the shortest
+		// one through them.
+		void AStarPathFinderImpl::ResetTmpLandmarkDistances()
+		{
+			landmarks2 = m->GateLandmarks();
+			if (landmarks2 == nullptr)
+				return;
+			int k = landmarks2->K();
+			tmpLandmarkDistances.assign(tmpCells.size() * k, inf);
+			for (int j = 0; j < tmpCells.size(); ++j)
+			{
+				int*						row = &tmpLandmarkDistances[j * k];
+				NeighbourVertexVisitor<int> visitor = [this, row, k](int v, int cost) {
+					int i = m->GateCellIndex(v);
+					if (i == -1)
+						return; // the other tmp cell.
+					const int* a = landmarks2->DistancesOf(i);
+					for (int l = 0; l < k; ++l)
+					{
+						if (a[l] != inf)
+							row[l] = std::min(row[l], a[l] + cost);
+					}
+				};
+				tmp.ForEachNeighbours(tmpCells[j], visitor);
+			}
+		}
+
+		const int* AStarPathFinderImpl::LandmarkDistancesOf(int i) const
+		{
+			return i < numGateCellIndexes ? landmarks2->DistancesOf(i)
+										  : &tmpLandmarkDistances[(i - numGateCellIndexes) * landmarks2->K()];
 		}
 
 		// Collects the gate cells on node path if ComputeNodeRoutes is successfully called and any further
 		// ComputeGateRoutes call specifics the useNodePath true.
 		// Notes that the start and target should be also collected.
-		void AStarPathFinderImpl::CollectGateCellsOnNodePath(std::unordered_set<int>& gateCellsOnNodePath,
-			const NodePath&															  nodePath)
+		void AStarPathFinderImpl::CollectGateCellsOnNodePath(const NodePath& nodePath)
 		{
-			gateCellsOnNodePath.insert(s);
-			gateCellsOnNodePath.insert(t);
+			onNodePath[SearchIndexOf(s)] = 1;
+			onNodePath[SearchIndexOf(t)] = 1;
 
 			// A visitor to collect all gate cells of a node.
-			int			i = 0;
-			GateVisitor visitor = [this, &i, &gateCellsOnNodePath, &nodePath](const Gate* gate) {
+			// It captures only two pointers, small enough to be stored inside the std::function.
+			QdNode*		next = nullptr;
+			GateVisitor visitor = [this, &next](const Gate* gate) {
 				// Collect only the gates between aNode and next node on the path.
-				if (i != nodePath.size() - 1 && gate->bNode == nodePath[i + 1].first)
+				if (gate->bNode == next)
 				{
-					gateCellsOnNodePath.insert(gate->a);
-					gateCellsOnNodePath.insert(gate->b);
+					onNodePath[m->GateCellIndex(gate->a)] = 1;
+					onNodePath[m->GateCellIndex(gate->b)] = 1;
 				};
 			};
 
-			for (; i != nodePath.size(); ++i)
+			for (int i = 0; i + 1 < nodePath.size(); ++i)
+			{
+				next = nodePath[i + 1].first;
 				m->ForEachGateInNode(nodePath[i].first, visitor);
+			}
 		}
 
 		int AStarPathFinderImpl::ComputeGateRoutes(GateRouteCollector& collector,
 			const NodePath&											   nodePath)
 		{
+			QDPF_TRACE_SCOPE("AStarPathFinder::ComputeGateRoutes");
+			StageTimer timer(stats != nullptr ? &stats->GateStageUs : nullptr);
+
 			// any one of start and target are out of map bounds.
 			if (sNode == nullptr || tNode == nullptr)
 				return -1;
@@ -132,36 +277,95 @@ namespace QDPF
 				return 0;
 			}
 
+			// The gate graph is connected the same way as the node graph, no search is needed if the
+			// oracle tells they are in different components. A node without id is not on the node graph,
+			// the oracle doesn't know it.
+			auto oracle = m->NodeDistanceOracle();
+			int	 sId = m->NodeId(sNode), tId = m->NodeId(tNode);
+			if (oracle != nullptr && sId != -1 && tId != -1 && !oracle->Reachable(sId, tId))
+				return -1;
+
+			ResetSearchIndexes();
+			ResetTmpLandmarkDistances();
+			int n = numGateCellIndexes + tmpCells.size();
+
 			// If useNodePath then collect all gate cells for these node.
-			std::unordered_set<int> gateCellsOnNodePath;
 			if (nodePath.size())
-				CollectGateCellsOnNodePath(gateCellsOnNodePath, nodePath);
+			{
+				onNodePath.Resize(n);
+				onNodePath.NewGeneration();
+				CollectGateCellsOnNodePath(nodePath);
+			}
 
 			// Collector for path result.
-			A2::PathCollector collector1 = [this, &collector](int u, int cost) {
-				auto [x, y] = m->UnpackXY(u);
+			auto collector1 = [this, &collector](int i, int cost) {
+				auto [x, y] = m->UnpackXY(CellOfSearchIndex(i));
 				collector(x, y, cost);
 			};
 
-			// We only care about the neighbour cells on the gateCellsOnNodePath,
-			// if a non-empty nodePath is provided.
-			A2::NeighbourFilterTesterT neighbourTester = [this, &gateCellsOnNodePath, &nodePath](int v) {
-				if (nodePath.size() > 0 && gateCellsOnNodePath.find(v) == gateCellsOnNodePath.end())
+			// We only care about the neighbour cells on the node path, if a non-empty nodePath is provided.
+			auto neighbourTester = [this, &nodePath](int v) {
+				if (nodePath.size() > 0 && !onNodePath[v])
 					return false;
 				return true;
 			};
 
-			// Collector for neighbour gate cells.
-			A2::NeighboursCollectorT neighborsCollector = [this](int					   u,
-															  NeighbourVertexVisitor<int>& visitor) {
-				ForEachNeighbourGateWithST(u, visitor);
+			// Collector for neighbour gate cells: the neighbours on the tmp graph are cells, and they are
+			// converted to search indexes by tmpVisitor. The neighbours on the gate graph are visited by
+			// dense indexes directly.
+			auto neighborsCollector = [this](int i, auto& visitor) {
+				NeighbourVertexVisitor<int> tmpVisitor = [this, &visitor](int v, int cost) {
+					visitor(SearchIndexOf(v), cost);
+				};
+				tmp.ForEachNeighbours(CellOfSearchIndex(i), tmpVisitor);
+				if (i < numGateCellIndexes)
+					m->ForEachNeighbourGateCellIndexes(i, visitor);
 			};
 
-			// Distance function
-			A2::Distance distance = [this](int u, int v) { return this->m->Distance(u, v); };
+			// Distance function, tightened by the landmarks if there are.
+			auto distance = [this](int i, int j) {
+				int d = this->m->Distance(CellOfSearchIndex(i), CellOfSearchIndex(j));
+				if (landmarks2 != nullptr)
+					d = std::max(d, Landmarks::LowerBound(LandmarkDistancesOf(i), LandmarkDistancesOf(j),
+										landmarks2->K()));
+				return d;
+			};
 
 			// Compute
-			return astar2.Compute(s, t, collector1, distance, neighborsCollector, neighbourTester);
+			auto searchStats = stats != nullptr ? &stats->GateSearch : nullptr;
+
+			// On the contraction hierarchy, the start and target (if they aren't gate cells) are taken as
+			// the lowest vertices, so all their edges go upward.
+			auto hierarchy = m->GateHierarchy();
+			if (hierarchy != nullptr && nodePath.empty())
+			{
+				auto upNeighborsCollector = [this, hierarchy](int i, auto& visitor) {
+					if (i < numGateCellIndexes)
+					{
+						hierarchy->ForEachUpNeighbours(i, visitor);
+						return;
+					}
+					NeighbourVertexVisitor<int> tmpVisitor = [this, &visitor](int v, int cost) {
+						visitor(SearchIndexOf(v), cost);
+					};
+					tmp.ForEachNeighbours(CellOfSearchIndex(i), tmpVisitor);
+				};
+				// the edges of the start and target are on the tmp graph, they are not shortcuts.
+				auto unpacker = [this, hierarchy](int i, int j, int cost, auto& visitor) {
+					if (i < numGateCellIndexes && j < numGateCellIndexes)
+						hierarchy->Unpack(i, j, visitor);
+					else
+						visitor(j, cost);
+				};
+				return astar2c.ComputeWith(SearchIndexOf(s), SearchIndexOf(t), collector1, upNeighborsCollector,
+					unpacker, searchStats, n);
+			}
+
+			if (bidirectional)
+				return astar2b.ComputeWith(SearchIndexOf(s), SearchIndexOf(t), collector1, distance,
+					neighborsCollector, neighbourTester, searchStats, n);
+			return astar2.ComputeWith(SearchIndexOf(s), SearchIndexOf(t), collector1, distance,
+				neighborsCollector, neighbourTester, searchStats, n);
 		}
 
 		// ComputeGateRoutes, not using a computed nodePath.
@@ -5,7 +5,6 @@
 
 #include <cassert>
 #include <cstdlib>
-#include <queue>
 
 #include "Base.h"
 
@@ -74,40 +73,43 @@ namespace QDPF
 			nodesOverlappingQueryRangeCollector = [this](QdNode* node) {
 				// we care about only leaf nodes with no obstacles
 				if (node->isLeaf && node->objects.empty())
-					nodesOverlappingQueryRange.insert(node);
+				{
+					nodesOverlappingQueryRange.push_back(node);
+					int id = m->NodeId(node);
+					if (id != -1)
+						nodesInQueryRangeMarks[id] = true;
+				}
 			};
 
 			// gatesInNodesOverlappingQueryRangeCollector is to collect gates inside a single node within the
 			// nodesOverlappingQueryRange.
+			// the gates of a gate cell are visited in a row, the cell is collected once.
 			gatesInNodesOverlappingQueryRangeCollector = [this](const Gate* gate) {
-				gatesInNodesOverlappingQueryRange.insert(gate->a);
-			};
-
-			// ffa1NeighborsCollector is to compute node flow field, it's used to visit every neighbour
-			// vertex for given node.
-			ffa1NeighborsCollector = [this](QdNode* u, NeighbourVertexVisitor<QdNode*>& visitor) {
-				m->ForEachNeighbourNodes(u, visitor);
-			};
-
-			// ffa2NeighborsCollector is for computing gate flow field, it's used to visit every neighbour
-			// gate cells for given gate cell u.
-			// It collects neighbour on the { tmp + map } 's gate graph.
-			ffa2NeighborsCollector = [this](int u, NeighbourVertexVisitor<int>& visitor) {
-				ForEachNeighbourGateWithST(u, visitor);
+				auto& cells = gatesInNodesOverlappingQueryRange;
+				if (cells.empty() || cells.back() != gate->a)
+					cells.push_back(gate->a);
 			};
 		}
 
 		void FlowFieldPathFinderImpl::Reset(const QuadtreeMap* m, int x2, int y2,
-			const Rectangle& qrange)
+			const Rectangle& qrange, PathfinderStats* stats)
 		{
+			QDPF_TRACE_SCOPE("FlowFieldPathFinder::Reset");
+
 			// debug mode, checks m, it's nullptr if mapx didn't find one.
 			assert(m != nullptr);
 
+			this->stats = stats;
+			if (stats != nullptr)
+				*stats = PathfinderStats{};
+			StageTimer timer(stats != nullptr ? &stats->ResetUs : nullptr);
+
 			// resets the attributes.
 			this->m = m;
 			this->x2 = x2, this->y2 = y2;
 			this->qrange = qrange; // copy updated
 			tNode = nullptr;
+			hasTmpCellsRect = false;
 
 			// the given qrange is invalid.
 			if (!(qrange.x1 <= qrange.x2 && qrange.y1 <= qrange.y2))
@@ -130,6 +132,8 @@ namespace QDPF
 
 			// find all nodes overlapping with qrange.
 			nodesOverlappingQueryRange.clear();
+			nodesInQueryRangeMarks.Resize(m->NumNodeIds());
+			nodesInQueryRangeMarks.NewGeneration();
 			m->NodesInRange(this->qrange, nodesOverlappingQueryRangeCollector);
 
 			// find all gates inside nodesOverlappingQueryRange.
@@ -139,10 +143,9 @@ namespace QDPF
 				m->ForEachGateInNode(node, gatesInNodesOverlappingQueryRangeCollector);
 			}
 
-			gateCellsOnNodeFields.clear();
-
 			// Rebuild the tmp graph.
 			PathFinderHelper::Reset(this->m);
+			numGateCellIndexes = m->NumGateCellIndexes();
 
 			// Add the target cell to the gate graph
 			bool tIsGate = m->IsGateCell(tNode, t);
@@ -155,7 +158,7 @@ namespace QDPF
 				// and add it to gatesInNodesOverlappingQueryRange if it is.
 				if (x2 >= this->qrange.x1 && x2 <= this->qrange.x2 && y2 >= this->qrange.y1 && y2 <= this->qrange.y2)
 				{
-					gatesInNodesOverlappingQueryRange.insert(t);
+					gatesInNodesOverlappingQueryRange.push_back(t);
 				}
 			}
 
@@ -169,6 +172,8 @@ namespace QDPF
 
 			if (hasOverlap)
 			{
+				hasTmpCellsRect = true;
+				tmpCellsRect = overlap;
 				for (int x = overlap.x1; x <= overlap.x2; ++x)
 				{
 					for (int y = overlap.y1; y <= overlap.y2; ++y)
@@ -181,11 +186,14 @@ namespace QDPF
 							ConnectCellsOnTmpGraph(u, t);
 							// We should consider u as a new tmp "gate" cell.
 							//  we should add it to overlapping gates collection.
-							gatesInNodesOverlappingQueryRange.insert(u);
+							gatesInNodesOverlappingQueryRange.push_back(u);
 						}
 					}
 				}
 			}
+
+			if (stats != nullptr)
+				stats->NumTmpEdges = tmp.NumEdges();
 		}
 
 		// Computes node flow field.
@@ -193,6 +201,9 @@ namespace QDPF
 		// 2. Stops earlier if all nodes overlapping the query range are checked.
 		int FlowFieldPathFinderImpl::ComputeNodeFlowField(NodeFlowField& nodeFlowField)
 		{
+			QDPF_TRACE_SCOPE("FlowFieldPathFinder::ComputeNodeFlowField");
+			StageTimer timer(stats != nullptr ? &stats->NodeStageUs : nullptr);
+
 			if (nodeFlowField.Size())
 				nodeFlowField.Clear();
 
@@ -212,8 +223,8 @@ namespace QDPF
 
 			// stopf is a function to stop the flowfield algorithm from execution after given vertex (the
 			// node) is marked.
-			FFA1::StopAfterFunction stopf = [&n, this](QdNode* node) {
-				if (nodesOverlappingQueryRange.find(node) != nodesOverlappingQueryRange.end())
+			auto stopf = [&n, this](int id) {
+				if (nodesInQueryRangeMarks[id])
 					++n;
 				// nodesOverlappingQueryRange's size will always > 0.
 				return n >= nodesOverlappingQueryRange.size();
@@ -221,15 +232,30 @@ namespace QDPF
 
 			// Heuristic function for node level astar.
 			// node's center to qrange's center.
-			FFA1::HeuristicFunction ffa1Heuristic = [this](QdNode* node) {
+			auto ffa1Heuristic = [this](int id) {
+				auto node = m->NodeAt(id);
 				// node's center
 				int nodeCenterX = node->x1 + (node->x2 - node->x1) / 2;
 				int nodeCenterY = node->y1 + (node->y2 - node->y1) / 2;
 				return m->Distance(nodeCenterX, nodeCenterY, qrangeCenterX, qrangeCenterY);
 			};
 
+			// ffa1NeighborsCollector visits every neighbour vertex for given node id.
+			auto ffa1NeighborsCollector = [this](int u, auto& visitor) {
+				m->ForEachNeighbourNodeIds(u, visitor);
+			};
+
+			// a node without id is not on the node graph, the field contains only itself.
+			int tId = m->NodeId(tNode);
+			if (tId == -1)
+			{
+				nodeFlowField[tNode] = { tNode, 0 };
+				return 0;
+			}
+
 			// Compute flowfield on the node graph.
-			ffa1.Compute(tNode, nodeFlowField, ffa1Heuristic, ffa1NeighborsCollector, nullptr, stopf);
+			ffa1.ComputeWith(tId, ffa1Heuristic, ffa1NeighborsCollector, nullptr, stopf,
+				stats != nullptr ? &stats->NodeSearch : nullptr, m->NumNodeIds());
 
 			ShrinkNodeFlowField(nodeFlowField);
 			return 0;
@@ -239,40 +265,42 @@ namespace QDPF
 		// We traverse from the nodesOverlappingQueryRange, and picks all the nodes on the visited path,
 		// and remove all the unrelated nodes.
 		// This is to reduce number of nodes that will participate the further ComputeGateFlowField().
+		// The nodes are read from the results of ffa1, only the picked ones are put into nodeFlowField.
 		void FlowFieldPathFinderImpl::ShrinkNodeFlowField(NodeFlowField& nodeFlowField)
 		{
-			NodeFlowField f;
-
-			std::queue<QdNode*> q;
+			shrinkQueue.clear();
 			for (auto node : nodesOverlappingQueryRange)
-				q.push(node);
+				shrinkQueue.push_back(m->NodeId(node));
 
-			while (q.size())
+			for (int k = 0; k < shrinkQueue.size(); ++k)
 			{
-				auto node = q.front();
-				q.pop();
-				if (f.Exist(node))
+				int id = shrinkQueue[k];
+				if (id == -1)
 					continue;
-				auto [next, cost] = nodeFlowField[node];
+				auto node = m->NodeAt(id);
+				if (nodeFlowField.Exist(node))
+					continue;
+				int cost = ffa1.Cost(id);
 				if (cost == inf)
 					continue;
-				q.push(next);
-				f[node] = { next, cost };
+				int next = ffa1.Next(id);
+				shrinkQueue.push_back(next);
+				nodeFlowField[node] = { m->NodeAt(next), cost };
 			}
-
-			std::swap(f, nodeFlowField);
 		}
 
 		// collects the gate cells on the node flow field if ComputeNodeFlowField is successfully called
 		// and ComputeGateFlowField is called with useNodeFlowField is set true.
 		void FlowFieldPathFinderImpl::CollectGateCellsOnNodeField(const NodeFlowField& nodeFlowField)
 		{
-			gateCellsOnNodeFields.insert(t);
+			gateCellsOnNodeFields.Resize(NumSearchIndexes());
+			gateCellsOnNodeFields.NewGeneration();
+			gateCellsOnNodeFields[SearchIndexOf(t)] = true;
 
 			// We have to add all non-gate neighbours of t on the tmp graph.
 			NeighbourVertexVisitor<int> tmpNeighbourVisitor = [this](int v, int cost) {
 				if (!m->IsGateCell(tNode, v))
-					gateCellsOnNodeFields.insert(v);
+					gateCellsOnNodeFields[SearchIndexOf(v)] = true;
 			};
 			tmp.ForEachNeighbours(t, tmpNeighbourVisitor);
 
@@ -281,14 +309,20 @@ namespace QDPF
 
 			// gateVisitor is to collect gates inside current node.
 			GateVisitor gateVisitor = [this, &node, &nextNode](const Gate* gate) {
-				// tNode has no next
-				if (node == tNode || node == nullptr || nextNode == nullptr)
+				// tNode has no next, all its gate cells are collected: the cells of tNode inside the
+				// query range may be reached only via them.
+				if (node == tNode)
+				{
+					gateCellsOnNodeFields[m->GateCellIndex(gate->a)] = true;
+					return;
+				}
+				if (node == nullptr || nextNode == nullptr)
 					return;
 				// collect only the gates between current node and next node.
 				if (gate->bNode == nextNode)
 				{
-					gateCellsOnNodeFields.insert(gate->a);
-					gateCellsOnNodeFields.insert(gate->b);
+					gateCellsOnNodeFields[m->GateCellIndex(gate->a)] = true;
+					gateCellsOnNodeFields[m->GateCellIndex(gate->b)] = true;
 				};
 			};
 
@@ -308,6 +342,9 @@ namespace QDPF
 		int FlowFieldPathFinderImpl::ComputeGateFlowField(GateFlowField& gateFlowField,
 			const NodeFlowField&										 nodeFlowField)
 		{
+			QDPF_TRACE_SCOPE("FlowFieldPathFinder::ComputeGateFlowField");
+			StageTimer timer(stats != nullptr ? &stats->GateStageUs : nullptr);
+
 			if (gateFlowField.Size())
 				gateFlowField.Clear();
 
@@ -318,11 +355,13 @@ namespace QDPF
 
 			// Collects the gate cells between nodes.
 			if (nodeFlowField.Size())
-			{
-				if (gateCellsOnNodeFields.size())
-					gateCellsOnNodeFields.clear();
 				CollectGateCellsOnNodeField(nodeFlowField);
-			}
+
+			// Marks the gates inside the query range by search indexes.
+			gatesInQueryRangeMarks.Resize(NumSearchIndexes());
+			gatesInQueryRangeMarks.NewGeneration();
+			for (auto u : gatesInNodesOverlappingQueryRange)
+				gatesInQueryRangeMarks[SearchIndexOf(u)] = true;
 
 			// stops earlier if all gates inside the query range are checked.
 
@@ -330,45 +369,83 @@ namespace QDPF
 			// gatesOverlappingQueryRange.
 			int n = 0;
 
-			FFA2::StopAfterFunction stopf = [this, &n](int u) {
-				if (gatesInNodesOverlappingQueryRange.find(u) != gatesInNodesOverlappingQueryRange.end())
+			auto stopf = [this, &n](int i) {
+				if (gatesInQueryRangeMarks[i])
 					++n;
 				return n >= gatesInNodesOverlappingQueryRange.size();
 			};
 
 			// if useNodeFlowField is true, we visit only the gate cells on the node field.
-			FFA2::NeighbourFilterTesterT neighbourTester = [this, &nodeFlowField](int v) {
-				if (nodeFlowField.Size() > 0 && gateCellsOnNodeFields.find(v) == gateCellsOnNodeFields.end())
+			auto neighbourTester = [this, &nodeFlowField](int i) {
+				if (nodeFlowField.Size() > 0 && !gateCellsOnNodeFields[i])
 					return false;
 				return true;
 			};
 
 			// Heuristic function for gate level astar.
 			// gate cell to qrange's center.
-			FFA2::HeuristicFunction ffa2Heuristic = [this](int u) {
-				auto [x, y] = m->UnpackXY(u);
+			auto ffa2Heuristic = [this](int i) {
+				auto [x, y] = m->UnpackXY(CellOfSearchIndex(i));
 				return m->Distance(x, y, qrangeCenterX, qrangeCenterY);
 			};
 
-			// Why we use a packedGateFlowField over the original unpacked gateFlowField?
-			// reason: the gate graph is built on top of packed cell ids, so we have to do packings and
-			// unpackings during the flowfield algorithm. Thus it's better to unpack the cell ids later on
-			// the results.
-			PackedCellFlowField packedGateFlowField;
-			ffa2.Compute(t, packedGateFlowField, ffa2Heuristic, ffa2NeighborsCollector, neighbourTester,
-				stopf);
+			// ffa2NeighborsCollector visits every neighbour gate cells for given search index i, on the
+			// { tmp + map } 's gate graph: the neighbours on the tmp graph are cells, they are converted
+			// to search indexes, and the neighbours on the gate graph are visited by indexes directly.
+			auto ffa2NeighborsCollector = [this](int i, auto& visitor) {
+				NeighbourVertexVisitor<int> tmpVisitor = [this, &visitor](int v, int cost) {
+					visitor(SearchIndexOf(v), cost);
+				};
+				tmp.ForEachNeighbours(CellOfSearchIndex(i), tmpVisitor);
+				if (i < numGateCellIndexes)
+					m->ForEachNeighbourGateCellIndexes(i, visitor);
+			};
+
+			ffa2.ComputeWith(SearchIndexOf(t), ffa2Heuristic, ffa2NeighborsCollector, neighbourTester, stopf,
+				stats != nullptr ? &stats->GateSearch : nullptr, NumSearchIndexes());
 
 			// Unpack into the gate flowfield.
-			for (auto& [v, p] : packedGateFlowField.GetUnderlyingMap())
-			{
-				auto [next, cost] = p;
-				auto [x, y] = m->UnpackXY(v);
-				auto [x1, y1] = m->UnpackXY(next);
+			ffa2.ForEachVertex([this, &gateFlowField](int i, int next, int cost) {
+				auto [x, y] = m->UnpackXY(CellOfSearchIndex(i));
+				auto [x1, y1] = m->UnpackXY(CellOfSearchIndex(next));
 				gateFlowField[{ x, y }] = { { x1, y1 }, cost };
-			}
+			});
 			return 0;
 		}
 
+		int FlowFieldPathFinderImpl::SearchIndexOf(int u) const
+		{
+			int i = m->GateCellIndex(u);
+			if (i != -1)
+				return i;
+			if (u == t)
+				return numGateCellIndexes;
+			auto [x, y] = m->UnpackXY(u);
+			const auto& r = tmpCellsRect;
+			if (!hasTmpCellsRect || x < r.x1 || x > r.x2 || y < r.y1 || y > r.y2)
+				return -1;
+			return numGateCellIndexes + 1 + (x - r.x1) * (r.y2 - r.y1 + 1) + (y - r.y1);
+		}
+
+		int FlowFieldPathFinderImpl::CellOfSearchIndex(int i) const
+		{
+			if (i < numGateCellIndexes)
+				return m->GateCellAt(i);
+			if (i == numGateCellIndexes)
+				return t;
+			const auto& r = tmpCellsRect;
+			int			k = i - numGateCellIndexes - 1, h = r.y2 - r.y1 + 1;
+			return m->PackXY(r.x1 + k / h, r.y1 + k % h);
+		}
+
+		int FlowFieldPathFinderImpl::NumSearchIndexes() const
+		{
+			int n = numGateCellIndexes + 1;
+			if (hasTmpCellsRect)
+				n += (tmpCellsRect.x2 - tmpCellsRect.x1 + 1) * (tmpCellsRect.y2 - tmpCellsRect.y1 + 1);
+			return n;
+		}
+
 		int FlowFieldPathFinderImpl::ComputeGateFlowField(GateFlowField& gateFlowField)
 		{
 			NodeFlowField emptyNodeFlowField;
@@ -398,6 +475,9 @@ namespace QDPF
 		int FlowFieldPathFinderImpl::ComputeFinalFlowField(FinalFlowField& finalFlowField,
 			const GateFlowField&										   gateFlowField)
 		{
+			QDPF_TRACE_SCOPE("FlowFieldPathFinder::ComputeFinalFlowField");
+			StageTimer timer(stats != nullptr ? &stats->FinalStageUs : nullptr);
+
 			// ensures the finalFlowField is empty
 			if (finalFlowField.Size())
 				finalFlowField.Clear();
@@ -407,12 +487,23 @@ namespace QDPF
 			if (m->IsObstacle(x2, y2))
 				return -1;
 
-			// f[x][y] is the cost from the cell (x,y) to the target, all cells are initialized to inf.
-			Final_F f;
-			// from[x][y] stores which neighbour cell where the min value comes from.
-			Final_From from;
-			// b[x][y] indicates whether the (x,y)'s f and from values should be derived via DP.
-			Final_B b;
+			// the DP reads and writes only the cells of the nodes overlapping the query range.
+			finalRect = qrange;
+			for (auto node : nodesOverlappingQueryRange)
+			{
+				finalRect.x1 = std::min(finalRect.x1, node->x1), finalRect.y1 = std::min(finalRect.y1, node->y1);
+				finalRect.x2 = std::max(finalRect.x2, node->x2), finalRect.y2 = std::max(finalRect.y2, node->y2);
+			}
+			int numFinalCells = (finalRect.x2 - finalRect.x1 + 1) * (finalRect.y2 - finalRect.y1 + 1);
+
+			// f[i] is the cost from the cell to the target, all cells are initialized to inf.
+			auto& f = finalF;
+			// from[i] stores which neighbour cell where the min value comes from.
+			auto& from = finalFrom;
+			// b[i] indicates whether the cell's f and from values should be derived via DP.
+			auto& b = finalB;
+			f.Resize(numFinalCells), from.Resize(numFinalCells), b.Resize(numFinalCells);
+			f.NewGeneration(), from.NewGeneration(), b.NewGeneration();
 
 			// initialize f from computed gate flow field.
 			for (auto& [v, p] : gateFlowField.GetUnderlyingMap())
@@ -453,9 +544,13 @@ namespace QDPF
 						continue;
 				}
 
-				b[x][y] = true;
-				f[x][y] = cost;
-				from[x][y] = m->PackXY(x2, y2);
+				// a cell outside the nodes overlapping the query range is never read.
+				if (x < finalRect.x1 || x > finalRect.x2 || y < finalRect.y1 || y > finalRect.y2)
+					continue;
+				int i = FinalIndexOf(x, y);
+				b[i] = true;
+				f[i] = cost;
+				from[i] = m->PackXY(x2, y2);
 			}
 
 			// cost unit on HV(horizonal and vertical) and diagonal directions.
@@ -468,8 +563,8 @@ namespace QDPF
 				// cells inside both in tNode and the qrange are already computed in the ComputeGateFlowField.
 				if (node == tNode)
 					continue;
-				ComputeFinalFlowFieldDP1(node, f, from, b, c1, c2);
-				ComputeFinalFlowFieldDP2(node, f, from, b, c1, c2);
+				ComputeFinalFlowFieldDP1(node, c1, c2);
+				ComputeFinalFlowFieldDP2(node, c1, c2);
 			}
 
 			// computes the flow field in the query range.
@@ -478,13 +573,14 @@ namespace QDPF
 			{
 				for (int y = qrange.y1; y <= qrange.y2; ++y)
 				{
-					// (x1,y1) is the next cell to go.
-					auto [x1, y1] = m->UnpackXY(from[x][y]);
+					int i = FinalIndexOf(x, y);
 					// f is inf: unreachable
-					if (f[x][y] == inf || from[x][y] == inf)
+					if (f[i] == inf || from[i] == inf)
 						continue;
+					// (x1,y1) is the next cell to go.
+					auto [x1, y1] = m->UnpackXY(from[i]);
 					// {x,y} => next{x1,y1}, cost
-					finalFlowField[{ x, y }] = { { x1, y1 }, f[x][y] };
+					finalFlowField[{ x, y }] = { { x1, y1 }, f[i] };
 				}
 			}
 
@@ -494,43 +590,45 @@ namespace QDPF
 		// DP 1 of ComputeFinalFlowFieldInQueryRange inside a single leaf node.
 		// From left-top corner to right-bottom corner.
 		// c1 and c2 is the unit cost for HV and diagonal directions.
-		void FlowFieldPathFinderImpl::ComputeFinalFlowFieldDP1(const QdNode* node, Final_F& f,
-			Final_From& from, Final_B& b, int c1,
-			int c2)
+		void FlowFieldPathFinderImpl::ComputeFinalFlowFieldDP1(const QdNode* node, int c1, int c2)
 		{
-			int x1 = node->x1, y1 = node->y1, x2 = node->x2, y2 = node->y2;
+			auto &f = finalF, &from = finalFrom;
+			auto& b = finalB;
+			// I is the index of cell (x,y) in the DP arrays.
+			auto I = [this](int x, int y) { return FinalIndexOf(x, y); };
+			int	 x1 = node->x1, y1 = node->y1, x2 = node->x2, y2 = node->y2;
 			for (int y = y1; y <= y2; ++y)
 			{
 				for (int x = x1; x <= x2; ++x)
 				{
 					// skipping the cells that already computed in the gate flow field.
-					if (b[x][y])
+					if (b[I(x, y)])
 						continue;
 
 					int xfrom = -1, yfrom = -1;
 
-					if (x > x1 && y > y1 && f[x][y] > f[x - 1][y - 1] + c2)
+					if (x > x1 && y > y1 && f[I(x, y)] > f[I(x - 1, y - 1)] + c2)
 					{ // left-up
-						f[x][y] = f[x - 1][y - 1] + c2;
+						f[I(x, y)] = f[I(x - 1, y - 1)] + c2;
 						xfrom = x - 1, yfrom = y - 1;
 					}
-					if (y > y1 && f[x][y] > f[x][y - 1] + c1)
+					if (y > y1 && f[I(x, y)] > f[I(x, y - 1)] + c1)
 					{ // up
-						f[x][y] = f[x][y - 1] + c1;
+						f[I(x, y)] = f[I(x, y - 1)] + c1;
 						xfrom = x, yfrom = y - 1;
 					}
-					if (x > x1 && f[x][y] > f[x - 1][y] + c1)
+					if (x > x1 && f[I(x, y)] > f[I(x - 1, y)] + c1)
 					{ // left
-						f[x][y] = f[x - 1][y] + c1;
+						f[I(x, y)] = f[I(x - 1, y)] + c1;
 						xfrom = x - 1, yfrom = y;
 					}
-					if (y > y1 && x < x2 && f[x][y] > f[x + 1][y - 1] + c2)
+					if (y > y1 && x < x2 && f[I(x, y)] > f[I(x + 1, y - 1)] + c2)
 					{ // right-up
-						f[x][y] = f[x + 1][y - 1] + c2;
+						f[I(x, y)] = f[I(x + 1, y - 1)] + c2;
 						xfrom = x + 1, yfrom = y - 1;
 					}
 					if (xfrom != -1)
-						from[x][y] = m->PackXY(xfrom, yfrom);
+						from[I(x, y)] = m->PackXY(xfrom, yfrom);
 				}
 			}
 		}
@@ -538,43 +636,45 @@ namespace QDPF
 		// DP 2 of ComputeFinalFlowFieldInQueryRange  inside a single leaf node.
 		// From right-bottom corner to left-top corner.
 		// c1 and c2 is the unit cost for HV and diagonal directions.
-		void FlowFieldPathFinderImpl::ComputeFinalFlowFieldDP2(const QdNode* node, Final_F& f,
-			Final_From& from, Final_B& b, int c1,
-			int c2)
+		void FlowFieldPathFinderImpl::ComputeFinalFlowFieldDP2(const QdNode* node, int c1, int c2)
 		{
-			int x1 = node->x1, y1 = node->y1, x2 = node->x2, y2 = node->y2;
+			auto &f = finalF, &from = finalFrom;
+			auto& b = finalB;
+			// I is the index of cell (x,y) in the DP arrays.
+			auto I = [this](int x, int y) { return FinalIndexOf(x, y); };
+			int	 x1 = node->x1, y1 = node->y1, x2 = node->x2, y2 = node->y2;
 			for (int y = y2; y >= y1; --y)
 			{
 				for (int x = x2; x >= x1; --x)
 				{
 					// skipping the cells that already computed in the gate flow field.
-					if (b[x][y])
+					if (b[I(x, y)])
 						continue;
 
 					int xfrom = -1, yfrom = -1;
 
-					if (x < x2 && y < y2 && f[x][y] > f[x + 1][y + 1] + c2)
+					if (x < x2 && y < y2 && f[I(x, y)] > f[I(x + 1, y + 1)] + c2)
 					{ // right-bottom
-						f[x][y] = f[x + 1][y + 1] + c2;
+						f[I(x, y)] = f[I(x + 1, y + 1)] + c2;
 						xfrom = x + 1, yfrom = y + 1;
 					}
-					if (x < x2 && f[x][y] > f[x + 1][y] + c1)
+					if (x < x2 && f[I(x, y)] > f[I(x + 1, y)] + c1)
 					{ // right
-						f[x][y] = f[x + 1][y] + c1;
+						f[I(x, y)] = f[I(x + 1, y)] + c1;
 						xfrom = x + 1, yfrom = y;
 					}
-					if (y < y2 && f[x][y] > f[x][y + 1] + c1)
+					if (y < y2 && f[I(x, y)] > f[I(x, y + 1)] + c1)
 					{ // bottom
-						f[x][y] = f[x][y + 1] + c1;
+						f[I(x, y)] = f[I(x, y + 1)] + c1;
 						xfrom = x, yfrom = y + 1;
 					}
-					if (y < y2 && x > x1 && f[x][y] > f[x - 1][y + 1] + c2)
+					if (y < y2 && x > x1 && f[I(x, y)] > f[I(x - 1, y + 1)] + c2)
 					{ // left-bottom
-						f[x][y] = f[x - 1][y + 1] + c2;
+						f[I(x, y)] = f[I(x - 1, y + 1)] + c2;
 						xfrom = x - 1, yfrom = y + 1;
 					}
 					if (xfrom != -1)
-						from[x][y] = m->PackXY(xfrom, yfrom);
+						from[I(x, y)] = m->PackXY(xfrom, yfrom);
 				}
 			}
 		}
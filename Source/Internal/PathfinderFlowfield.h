@@ -5,14 +5,14 @@
 #define QDPF_INTERNAL_PATHFINDER_FLOW_FIELD_HPP
 
 #include <functional>
-#include <queue> // for std::priority_queue
 #include <unordered_map>
-#include <unordered_set>
+#include <utility> // for std::as_const
 #include <vector>
 
 #include "Base.h"
 #include "PathfinderHelper.h"
 #include "QuadtreeMap.h"
+#include "Trace.h"
 
 // FlowFieldPathFinder
 // ~~~~~~~~~~~~~~~~~~~
@@ -148,7 +148,15 @@ namespace QDPF
 		// 1. Compute the cost field by reverse-traversing from the target, using the astar algorithm.
 		// 2. Compute the flow field by comparing each vertex with its neighours vertices.
 
-		template <typename Vertex, Vertex NullVertex>
+		// SearchStatesT is the containers of the search states, see UnorderedMapSearchStates (default)
+		// and VectorSearchStates. The from of a vertex is its next vertex in the flow field.
+		// QueueT is the priority queue policy, see BinaryHeapQueue (default), IndexedDaryHeapQueue and
+		// RadixHeapQueue.
+		// The search states and the queue buffer are kept across Compute calls, so a long-lived
+		// FlowFieldAlgorithm on VectorSearchStates doesn't allocate in steady state.
+		template <typename Vertex, Vertex NullVertex,
+			typename SearchStatesT = UnorderedMapSearchStates<Vertex, NullVertex>,
+			typename QueueT = BinaryHeapQueue<Vertex>>
 		class FlowFieldAlgorithm
 		{
 		public:
@@ -168,6 +176,7 @@ namespace QDPF
 			// 2. t is the target vertex.
 			// 3. field is the destination field to fill results.
 			// 4. neighborTester is to filter neighbor.
+			// 5. stats is optional, the search counters are added to it if it's not nullptr.
 			//
 			// Note: the neighborsCollector should use the negative direction of the edges in the original
 			// directed graph. But specially speaking, for our case, on the grid map, either the gate graph
@@ -175,7 +184,44 @@ namespace QDPF
 			// original direction is just ok.
 			void Compute(Vertex t, FlowFieldT& field, HeuristicFunction& heuristic,
 				NeighboursCollectorT& neighborsCollector, NeighbourFilterTesterT neighborTester,
-				StopAfterFunction& stopAfterTester);
+				StopAfterFunction& stopAfterTester, SearchStats* stats = nullptr);
+
+			// The same to Compute, but takes the functions as template callables, so that the whole
+			// expansion loop can be inlined by the compiler:
+			// 1. heuristic: int(Vertex u), or nullptr.
+			// 2. neighborsCollector: void(Vertex u, Visitor& visitor), the visitor is a callable
+			//    void(Vertex v, int cost), it should be taken as a template (e.g. auto&).
+			// 3. neighborTester: bool(Vertex v), or nullptr to visit all neighbours.
+			// 4. stopAfterTester: bool(Vertex u), or nullptr.
+			// The results are kept until next computation, read them by Cost, Next and ForEachVertex.
+			// The n is the upper bound (exclusive) of the vertices, only used by VectorSearchStates.
+			template <typename HeuristicF, typename NeighboursCollectorF, typename NeighbourFilterTesterF,
+				typename StopAfterF>
+			void ComputeWith(Vertex t, HeuristicF&& heuristic, NeighboursCollectorF&& neighborsCollector,
+				NeighbourFilterTesterF&& neighborTester, StopAfterF&& stopAfterTester,
+				SearchStats* stats = nullptr, int n = 0);
+
+			// Returns the cost to target of given vertex, by last computation.
+			// Returns inf if it's not reached.
+			int Cost(Vertex v) const { return std::as_const(states.f)[v]; }
+
+			// Returns the next vertex of given vertex, by last computation.
+			// Returns NullVertex if it's not reached.
+			Vertex Next(Vertex v) const { return std::as_const(states.from)[v]; }
+
+			// Visits each reached vertex by last computation: visitor(v, next, cost).
+			template <typename Visitor>
+			void ForEachVertex(Visitor&& visitor) const
+			{
+				for (auto v : reached)
+					visitor(v, Next(v), Cost(v));
+			}
+
+		private:
+			SearchStatesT states;
+			QueueT		  q;
+			// the reached vertices, in order.
+			std::vector<Vertex> reached;
 		};
 
 		//////////////////////////////////////
@@ -197,7 +243,10 @@ namespace QDPF
 			// * the the map instance
 			// * target (x2,y2)
 			// * the query range rectangle to fill results.
-			void Reset(const QuadtreeMap* m, int x2, int y2, const Rectangle& qrange);
+			// * the statistics to fill (optional), it's cleared, and then filled by this call and the
+			//   following Compute calls.
+			void Reset(const QuadtreeMap* m, int x2, int y2, const Rectangle& qrange,
+				PathfinderStats* stats = nullptr);
 
 			// Computes the node flow field.
 			// Returns -1 on failure (unreachable).
@@ -215,12 +264,14 @@ namespace QDPF
 		private:
 			// ~~~~~~~  algorithm handlers ~~~~~~~~
 
-			// for computing node flow field.
-			using FFA1 = FlowFieldAlgorithm<QdNode*, nullptr>;
+			// for computing node flow field, on node ids (see QuadtreeMap::NodeId).
+			// The heuristics to the query range are nearly consistent, a few priorities lower than the
+			// last popped one are kept aside by the radix heap.
+			using FFA1 = FlowFieldAlgorithm<int, inf, VectorSearchStates<inf>, RadixHeapQueue<int>>;
 			FFA1 ffa1;
 
-			// for computing gate flow field.
-			using FFA2 = FlowFieldAlgorithm<int, inf>;
+			// for computing gate flow field, on search indexes (see SearchIndexOf).
+			using FFA2 = FlowFieldAlgorithm<int, inf, VectorSearchStates<inf>, RadixHeapQueue<int>>;
 			FFA2 ffa2;
 
 			// ~~~~~~~ stateful values for current round compution.~~~~~~~~
@@ -241,108 +292,181 @@ namespace QDPF
 			// nodes overlapping with the query range.
 			// this node collection is to stop the ffa1 pathfinder's compution earlier once
 			// all the related nodes are marked via flowfield algorithm.
-			std::unordered_set<QdNode*> nodesOverlappingQueryRange;
+			// Reused across queries.
+			std::vector<QdNode*> nodesOverlappingQueryRange;
+			// marks the node ids of nodesOverlappingQueryRange, reused across queries.
+			StampedVectorBool<false> nodesInQueryRangeMarks;
 
 			// this gate collection includes two parts:
 			// 1. gate cells inside the nodes within nodesOverlappingQueryRange.
 			// 2. virtual gate cells inside the tmp graph.
 			// Its purpose is also to stop the ffa2 pathfinder's compution earlier once all the
 			// related gates are marked via flowfield algorithm.
-			std::unordered_set<int> gatesInNodesOverlappingQueryRange;
+			// The cells are distinct: a gate cell is inside a single node, and the virtual ones aren't
+			// gate cells. Reused across queries.
+			std::vector<int> gatesInNodesOverlappingQueryRange;
 
 			// to reduce the number of gates that participating the ComputeGateFlowField():
 			// we collect the gate cells on the computed node fields, only gate inside this collection will
 			// participate the further ComputeGateFlowField() if there was a previous successful
 			// ComputeNodeFlowField() call.
-			std::unordered_set<int> gateCellsOnNodeFields;
+			// Marked by search indexes, reused across queries.
+			StampedVectorBool<false> gateCellsOnNodeFields;
+
+			// marks the search indexes of gatesInNodesOverlappingQueryRange, reused across queries.
+			StampedVectorBool<false> gatesInQueryRangeMarks;
+
+			// node ids queue for ShrinkNodeFlowField, reused across queries.
+			std::vector<int> shrinkQueue;
+
+			// ~~~~~~~ search indexes for computing gate flow field ~~~~~~
+			// The gate search runs on dense indexes instead of cell ids: a gate cell's search index is
+			// its gate cell index, the target (if it isn't a gate cell) is indexed right after all gate
+			// cells, and then the cells of tmpCellsRect (the overlap of the target node and the query
+			// range, connected to the target on the tmp graph), column by column.
+			int		  numGateCellIndexes = 0;
+			Rectangle tmpCellsRect;
+			bool	  hasTmpCellsRect = false;
+
+			// Returns the search index of cell u, -1 if it's not a vertex of the gate search.
+			int SearchIndexOf(int u) const;
+			int CellOfSearchIndex(int i) const;
+			// Returns the upper bound (exclusive) of the search indexes.
+			int NumSearchIndexes() const;
 
 			// ~~~~~~~~ compution lambdas (optimization for reuses) ~~~~~~~~~
 			// lambda to collect quadtree nodes overlapping with the qrange.
 			QdNodeVisitor nodesOverlappingQueryRangeCollector = nullptr;
 			// lambda to collect gate cells inside a node within nodesOverlappingQueryRange.
 			GateVisitor gatesInNodesOverlappingQueryRangeCollector = nullptr;
-			// neighbor queriers for the flowfield algorithm.
-			FFA1::NeighboursCollectorT ffa1NeighborsCollector = nullptr;
-			FFA2::NeighboursCollectorT ffa2NeighborsCollector = nullptr;
 
 			// ~~~~~~~~ internal functions ~~~~~~~~~~~
 
 			void CollectGateCellsOnNodeField(const NodeFlowField& nodeFlowField);
 			void ShrinkNodeFlowField(NodeFlowField& nodeFlowField);
 
-			// DP value container of f for ComputeFinalFlowFieldInQueryRange()
-			using Final_F = NestedDefaultedUnorderedMap<int, int, int, inf>;
-			// DP value container of from for ComputeFinalFlowFieldInQueryRange()
-			using Final_From = NestedDefaultedUnorderedMap<int, int, int, inf>;
-			// B[x][y] is the container indicates that whether cell (x,y) is on the computed gate flow field.
-			// which is a helper typing for ComputeFinalFlowFieldInQueryRange().
-			using Final_B = NestedDefaultedUnorderedMap<int, int, bool, false>;
+			// DP values of ComputeFinalFlowField, on the cells of finalRect (the bounding rectangle of the
+			// nodes overlapping the query range), by FinalIndexOf, reused across queries:
+			// 1. finalF is the cost from the cell to the target.
+			// 2. finalFrom is the packed neighbour cell where the min value comes from.
+			// 3. finalB indicates whether the cell is on the computed gate flow field.
+			Rectangle				 finalRect;
+			StampedVectorInt<inf>	 finalF, finalFrom;
+			StampedVectorBool<false> finalB;
+
+			int FinalIndexOf(int x, int y) const
+			{
+				return (x - finalRect.x1) * (finalRect.y2 - finalRect.y1 + 1) + (y - finalRect.y1);
+			}
 
 			void FindNeighbourCellByNext(int x, int y, int x1, int y1, int& x2, int& y2);
 
-			void ComputeFinalFlowFieldDP1(const QdNode* node, Final_F& f, Final_From& from, Final_B& b,
-				int c1, int c2);
-			void ComputeFinalFlowFieldDP2(const QdNode* node, Final_F& f, Final_From& from, Final_B& b,
-				int c1, int c2);
+			void ComputeFinalFlowFieldDP1(const QdNode* node, int c1, int c2);
+			void ComputeFinalFlowFieldDP2(const QdNode* node, int c1, int c2);
 		};
 
 		// ~~~~~~~~~~~~~~~ Implements FlowField Algorithm ~~~~~~~~~~~
 
-		template <typename Vertex, Vertex NullVertex>
-		void FlowFieldAlgorithm<Vertex, NullVertex>::Compute(Vertex t, FlowFieldT& f,
+		// The std::function callbacks are forwarded to ComputeWith.
+		template <typename Vertex, Vertex NullVertex, typename SearchStatesT, typename QueueT>
+		void FlowFieldAlgorithm<Vertex, NullVertex, SearchStatesT, QueueT>::Compute(Vertex t, FlowFieldT& f,
 			HeuristicFunction&	   heuristic,
 			NeighboursCollectorT&  neighborsCollector,
 			NeighbourFilterTesterT neighborTester,
-			StopAfterFunction&	   stopAfterTester)
+			StopAfterFunction&	   stopAfterTester,
+			SearchStats*		   stats)
 		{
-			// Pair of { cost, vertex}.
-			using P = std::pair<int, Vertex>;
+			// the expansion visitor of ComputeWith is wrapped by reference, without allocations.
+			auto neighborsCollector1 = [&neighborsCollector](Vertex u, auto& expand) {
+				NeighbourVertexVisitor<Vertex> visitor = std::ref(expand);
+				neighborsCollector(u, visitor);
+			};
+			ComputeWith(t, heuristic, neighborsCollector1, neighborTester, stopAfterTester, stats);
+			ForEachVertex([&f](Vertex v, Vertex next, int cost) { f[v] = { next, cost }; });
+		}
 
-			// astar
-			DefaultedUnorderedMapBool<Vertex, false> vis;
+		template <typename Vertex, Vertex NullVertex, typename SearchStatesT, typename QueueT>
+		template <typename HeuristicF, typename NeighboursCollectorF, typename NeighbourFilterTesterF,
+			typename StopAfterF>
+		void FlowFieldAlgorithm<Vertex, NullVertex, SearchStatesT, QueueT>::ComputeWith(Vertex t,
+			HeuristicF&&			 heuristic,
+			NeighboursCollectorF&&	 neighborsCollector,
+			NeighbourFilterTesterF&& neighborTester,
+			StopAfterF&&			 stopAfterTester,
+			SearchStats*			 stats,
+			int						 n)
+		{
+			QDPF_TRACE_SCOPE("FlowFieldAlgorithm::Compute");
 
-			// smallest-first queue, where P is { cost, vertex }
-			std::priority_queue<P, std::vector<P>, std::greater<P>> q;
+			// counters, they are always counted and added to stats at the end.
+			std::size_t numPushed = 0, numPopped = 0, numStale = 0, numVisited = 0, numFiltered = 0;
+
+			states.Reset(n);
+			auto& f = states.f;
+			auto& vis = states.vis;
+			auto& next = states.from;
+			reached.clear();
+
+			// smallest-first queue, ordered by { cost, vertex }
+			q.Reset(n);
 
 			// Notes that the target's next is itself.
-			f[t] = { t, 0 };
-			q.push({ 0, t });
+			f[t] = 0, next[t] = t;
+			reached.push_back(t);
+			q.Push(0, t);
+			++numPushed;
 
 			Vertex u;
 
 			// expand from u to v with cost c
-			NeighbourVertexVisitor<Vertex> expand = [&u, &neighborTester, &q, &t, &f, &heuristic](Vertex v,
-														int												 c) {
-				if (neighborTester != nullptr && !neighborTester(v))
+			auto expand = [this, &u, &neighborTester, &f, &next, &heuristic, &numPushed, &numVisited,
+							  &numFiltered](Vertex v, int c) {
+				++numVisited;
+				if (!InvokeOptional(neighborTester, true, v))
+				{
+					++numFiltered;
 					return;
-				int	 fu = f.Cost(u); // readonly
-				int	 fv = f.Cost(v); // readonly
-				auto g = fu + c;	 // existing real cost
-				auto cost = g;		 // future estimation cost
-				if (heuristic != nullptr)
-					cost += heuristic(v);
-				if (fv > g)
+				}
+				auto g = f[u] + c; // existing real cost
+				auto cost = g;	   // future estimation cost
+				cost += InvokeOptional(heuristic, 0, v);
+				if (f[v] > g)
 				{
-					fv = g;
-					q.push({ cost, v });
+					if (f[v] == inf)
+						reached.push_back(v);
+					f[v] = g;
+					q.Push(cost, v);
+					++numPushed;
 					// v comes from u, that is.
 					// In inversing view, u is the next way to go.
 					// g is the real cost.
-					f[v] = { u, g };
+					next[v] = u;
 				}
 			};
 
-			while (q.size())
+			while (!q.Empty())
 			{
-				u = q.top().second;
-				q.pop();
+				u = q.Pop();
+				++numPopped;
 				if (vis[u])
+				{
+					++numStale;
 					continue;
+				}
 				vis[u] = true;
-				if (stopAfterTester != nullptr && stopAfterTester(u))
+				if (InvokeOptional(stopAfterTester, false, u))
 					break;
 				neighborsCollector(u, expand);
 			}
+
+			if (stats != nullptr)
+			{
+				stats->NumPushedVertices += numPushed;
+				stats->NumPoppedVertices += numPopped;
+				stats->NumStaleVertices += numStale;
+				stats->NumVisitedNeighbours += numVisited;
+				stats->NumFilteredNeighbours += numFiltered;
+			}
 		}
 
 	} // namespace Internal
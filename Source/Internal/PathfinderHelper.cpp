@@ -3,6 +3,7 @@
 
 #include "PathfinderHelper.h"
 
+#include <algorithm> // for std::max
 #include <cassert>
 
 namespace QDPF
@@ -10,6 +11,79 @@ namespace QDPF
 	namespace Internal
 	{
 
+		// ~~~~~~~~~~~~~~~ TmpGraph ~~~~~~~~~~~
+
+		void TmpGraph::Clear()
+		{
+			for (int i = 0; i < cells.size(); ++i)
+				edges[i].clear();
+			cells.clear();
+			table.NewGeneration();
+			numEdges = 0;
+		}
+
+		void TmpGraph::AddEdge(int u, int v, int cost)
+		{
+			auto& e = edges[AddVertex(u)];
+			if (!e.empty() && e.back().first == v)
+				return;
+			e.push_back({ v, cost });
+			++numEdges;
+		}
+
+		int TmpGraph::VertexOf(int u) const
+		{
+			if (bits == 0)
+				return -1;
+			int mask = (1 << bits) - 1;
+			for (int k = Slot(u);; k = (k + 1) & mask)
+			{
+				int i = table[k];
+				if (i == -1 || cells[i] == u)
+					return i;
+			}
+		}
+
+		int TmpGraph::AddVertex(int u)
+		{
+			int i = VertexOf(u);
+			if (i != -1)
+				return i;
+			i = cells.size();
+			cells.push_back(u);
+			if (edges.size() < cells.size())
+				edges.emplace_back();
+			// keeps the load factor no more than 1/2.
+			if (cells.size() * 2 > (1u << bits))
+				Rehash();
+			else
+			{
+				int mask = (1 << bits) - 1, k = Slot(u);
+				while (table[k] != -1)
+					k = (k + 1) & mask;
+				table[k] = i;
+			}
+			return i;
+		}
+
+		// Doubles the slots, and inserts all the vertices again.
+		void TmpGraph::Rehash()
+		{
+			bits = std::max(bits + 1, 6);
+			int mask = (1 << bits) - 1;
+			table.Resize(1 << bits);
+			table.NewGeneration();
+			for (int i = 0; i < cells.size(); ++i)
+			{
+				int k = Slot(cells[i]);
+				while (table[k] != -1)
+					k = (k + 1) & mask;
+				table[k] = i;
+			}
+		}
+
+		// ~~~~~~~~~~~~~~~ PathFinderHelper ~~~~~~~~~~~
+
 		void PathFinderHelper::Reset(const QuadtreeMap* mPtr)
 		{
 			tmp.Clear();
@@ -33,12 +107,5 @@ namespace QDPF
 			m->ForEachGateInNode(node, visitor);
 		}
 
-		void PathFinderHelper::ForEachNeighbourGateWithST(int u,
-			NeighbourVertexVisitor<int>&					  visitor) const
-		{
-			tmp.ForEachNeighbours(u, visitor);
-			m->GetGateGraph().ForEachNeighbours(u, visitor);
-		}
-
 	} // namespace Internal
 } // namespace QDPF
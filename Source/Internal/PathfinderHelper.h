@@ -4,6 +4,16 @@
 #ifndef QDPF_INTERNAL_PATHFINDER_HELPER_HPP
 #define QDPF_INTERNAL_PATHFINDER_HELPER_HPP
 
+#include <algorithm>   // for std::push_heap, std::pop_heap, std::min
+#include <bit>         // for std::bit_width
+#include <cassert>     // for assert
+#include <chrono>      // for std::chrono
+#include <cstddef>     // for std::size_t
+#include <functional>  // for std::greater
+#include <type_traits> // for std::is_null_pointer_v, std::is_constructible_v
+#include <utility>     // for std::forward, std::pair
+#include <vector>      // for std::vector
+
 #include "Graph.h"
 #include "QuadtreeMap.h"
 
@@ -24,6 +34,372 @@ namespace QDPF
 		template <typename Vertex>
 		using NeighbourFilterTester = std::function<bool(Vertex)>;
 
+		// Calls an optional callable f with given arguments.
+		// Returns def if f is absent: a nullptr, or an empty std::function.
+		template <typename F, typename R, typename... Args>
+		inline R InvokeOptional(F& f, R def, Args&&... args)
+		{
+			if constexpr (std::is_null_pointer_v<std::remove_cv_t<F>>)
+				return def;
+			else
+			{
+				if constexpr (std::is_constructible_v<bool, F&>)
+				{
+					if (!f)
+						return def;
+				}
+				return f(std::forward<Args>(args)...);
+			}
+		}
+
+		// SearchStates of a search algorithm (e.g. AStar) on unordered maps keyed by vertex.
+		// f is the cost from the start, vis marks the expanded vertices and from[v] is the previous
+		// vertex of v on the path.
+		template <typename Vertex, Vertex NullVertex>
+		struct UnorderedMapSearchStates
+		{
+			DefaultedUnorderedMapInt<Vertex, inf>			  f;
+			DefaultedUnorderedMapBool<Vertex, false>		  vis;
+			DefaultedUnorderedMap<Vertex, Vertex, NullVertex> from;
+
+			// Prepares for a new search on n vertices, the maps are cleared.
+			void Reset(int) { f.Clear(), vis.Clear(), from.Clear(); }
+		};
+
+		// SearchStates on vectors, for dense integral vertices in range [0, n).
+		// It avoids the hashings, but occupies O(n) memory.
+		// The vectors are generation-stamped: kept across searches, they never need clearings, and
+		// don't reallocate once grown to the largest n.
+		template <int NullVertex>
+		struct VectorSearchStates
+		{
+			StampedVectorInt<inf>		 f;
+			StampedVectorBool<false>	 vis;
+			StampedVectorInt<NullVertex> from;
+
+			// Prepares for a new search on n vertices, the states of last search are dropped in O(1).
+			void Reset(int n)
+			{
+				f.Resize(n), vis.Resize(n), from.Resize(n);
+				f.NewGeneration(), vis.NewGeneration(), from.NewGeneration();
+			}
+		};
+
+		// Queue policies of a search algorithm (e.g. AStar), the smallest-first priority queues of
+		// vertices, ordered by { priority, vertex }:
+		// 1. Reset(n): clears the queue for a new search on n vertices.
+		// 2. Push(c, v): pushes vertex v with priority c.
+		// 3. Pop(): pops the vertex of the smallest priority.
+		// 4. Empty().
+		// They keep their buffers across searches.
+
+		// BinaryHeapQueue is a binary heap with lazy deletion: a vertex is pushed again on each
+		// decrease of its priority, the stale entries are skipped on popping by the search.
+		template <typename Vertex>
+		class BinaryHeapQueue
+		{
+		public:
+			void Reset(int) { q.clear(); }
+			bool Empty() const { return q.empty(); }
+			void Push(int c, Vertex v)
+			{
+				q.push_back({ c, v });
+				std::push_heap(q.begin(), q.end(), std::greater<P>());
+			}
+			Vertex Pop()
+			{
+				std::pop_heap(q.begin(), q.end(), std::greater<P>());
+				auto v = q.back().second;
+				q.pop_back();
+				return v;
+			}
+
+		private:
+			using P = std::pair<int, Vertex>;
+			std::vector<P> q;
+		};
+
+		// IndexedDaryHeapQueue is a D-ary heap indexed by dense integral vertices in range [0, n), with
+		// decrease-key: a vertex is in the queue at most once, pushing it again decreases its priority.
+		// It has no stale entries, so the heap is no larger than the number of vertices, and a larger D
+		// makes it shallower, at the cost of more comparisons on popping.
+		template <int D = 4>
+		class IndexedDaryHeapQueue
+		{
+		public:
+			// Clears the queue for n vertices, the positions are dropped in O(1).
+			void Reset(int n)
+			{
+				heap.clear();
+				pos.Resize(n);
+				pos.NewGeneration();
+			}
+
+			bool Empty() const { return heap.empty(); }
+
+			// Pushes vertex v with priority c, or decreases its priority if it's already in the queue.
+			// Does nothing if it's already in the queue with a smaller (or equal) priority.
+			void Push(int c, int v)
+			{
+				int i = pos[v];
+				if (i == -1)
+				{
+					i = heap.size();
+					heap.push_back({ c, v });
+				}
+				else if (c < heap[i].first)
+					heap[i].first = c;
+				else
+					return;
+				SiftUp(i);
+			}
+
+			int Pop()
+			{
+				int v = heap[0].second;
+				pos[v] = -1;
+				auto last = heap.back();
+				heap.pop_back();
+				if (!heap.empty())
+				{
+					heap[0] = last;
+					SiftDown(0);
+				}
+				return v;
+			}
+
+		private:
+			using P = std::pair<int, int>; // { priority, vertex }
+			std::vector<P> heap;
+			// the position of each vertex in the heap, -1 for not in it.
+			StampedVectorInt<-1> pos;
+
+			void SiftUp(int i)
+			{
+				auto p = heap[i];
+				while (i > 0)
+				{
+					int parent = (i - 1) / D;
+					if (!(p < heap[parent]))
+						break;
+					heap[i] = heap[parent];
+					pos[heap[i].second] = i;
+					i = parent;
+				}
+				heap[i] = p;
+				pos[p.second] = i;
+			}
+
+			void SiftDown(int i)
+			{
+				auto p = heap[i];
+				int	 n = heap.size();
+				while (true)
+				{
+					int first = i * D + 1;
+					if (first >= n)
+						break;
+					int best = first, last = std::min(first + D, n);
+					for (int k = first + 1; k < last; ++k)
+					{
+						if (heap[k] < heap[best])
+							best = k;
+					}
+					if (!(heap[best] < p))
+						break;
+					heap[i] = heap[best];
+					pos[heap[i].second] = i;
+					i = best;
+				}
+				heap[i] = p;
+				pos[p.second] = i;
+			}
+		};
+
+		// RadixHeapQueue is a monotone radix heap on the integral priorities, with lazy deletion (like
+		// BinaryHeapQueue). An item is kept in the bucket of the highest bit that its priority differs
+		// from the last popped one, a bucket is redistributed into the lower buckets only when it's
+		// reached on popping, so each item moves at most 32 times, without comparisons of the heap.
+		// The priorities are expected to be non-decreasing by popping, as Dijkstra's. A priority lower
+		// than the last popped one, e.g. by a slightly inconsistent heuristic, is kept in a binary heap
+		// popped before the buckets, so the pops are still by priorities, only the order among the ties
+		// may differ from a heap's. With Monotone set, such a priority is a bug, and asserted.
+		template <typename Vertex, bool Monotone = false>
+		class RadixHeapQueue
+		{
+		public:
+			void Reset(int)
+			{
+				for (auto& b : buckets)
+					b.clear();
+				below.clear();
+				last = 0, size = 0;
+			}
+
+			bool Empty() const { return size == 0; }
+
+			void Push(int c, Vertex v)
+			{
+				++size;
+				if (c < last)
+				{
+					assert(!Monotone && "RadixHeapQueue: priority lower than the last popped one");
+					below.push_back({ c, v });
+					std::push_heap(below.begin(), below.end(), std::greater<P>());
+					return;
+				}
+				buckets[BucketOf(c)].push_back({ c, v });
+			}
+
+			Vertex Pop()
+			{
+				--size;
+				if (!below.empty())
+				{
+					std::pop_heap(below.begin(), below.end(), std::greater<P>());
+					auto v = below.back().second;
+					below.pop_back();
+					return v;
+				}
+				if (buckets[0].empty())
+				{
+					// redistributes the first non-empty bucket by its smallest priority.
+					int i = 1;
+					while (buckets[i].empty())
+						++i;
+					auto& b = buckets[i];
+					last = b[0].first;
+					for (auto& p : b)
+						last = std::min(last, p.first);
+					for (auto& p : b)
+						buckets[BucketOf(p.first)].push_back(p);
+					b.clear();
+				}
+				auto v = buckets[0].back().second;
+				buckets[0].pop_back();
+				return v;
+			}
+
+		private:
+			using P = std::pair<int, Vertex>; // { priority, vertex }
+			// bucket 0 is for priority last, bucket k is for the priorities differ from last at bit k-1.
+			std::vector<P> buckets[33];
+			// the smallest-first binary heap of the priorities lower than last.
+			std::vector<P> below;
+			int			   last = 0;
+			int			   size = 0;
+
+			int BucketOf(int c) const
+			{
+				return std::bit_width(static_cast<unsigned int>(c ^ last));
+			}
+		};
+
+		// TmpGraph is the small directed graph of cells built by a path finder's Reset, connecting the
+		// start, target (and query range cells for flow field) to the gate cells.
+		// It's kept across queries: Clear keeps the buffers, so it doesn't allocate once grown to the
+		// largest query. The cells are mapped to dense vertices by an open addressing hash table.
+		class TmpGraph
+		{
+		public:
+			// Removes all the cells and edges.
+			void Clear();
+
+			// Adds an edge u => v of given cost. An edge same to the last one added from u is ignored,
+			// so the gates of a gate cell, which are visited in a row, are connected once.
+			void AddEdge(int u, int v, int cost);
+
+			// Visits the neighbour cells of u, the visitor is a callable void(int v, int cost).
+			template <typename Visitor>
+			void ForEachNeighbours(int u, Visitor&& visitor) const
+			{
+				int i = VertexOf(u);
+				if (i == -1)
+					return;
+				for (const auto& [v, cost] : edges[i])
+					visitor(v, cost);
+			}
+
+			std::size_t NumEdges() const { return numEdges; }
+
+		private:
+			// cells[i] is the cell of vertex i.
+			std::vector<int> cells;
+			// edges[i] is the { cell, cost } of the edges from vertex i, kept across clears, only the
+			// first cells.size() ones are in use.
+			std::vector<std::vector<std::pair<int, int>>> edges;
+			// table[k] is the vertex at slot k, -1 for empty. It has 1 << bits slots in use.
+			StampedVectorInt<-1> table;
+			int					 bits = 0;
+			std::size_t			 numEdges = 0;
+
+			int Slot(int u) const
+			{
+				return (static_cast<unsigned int>(u) * 2654435769u) >> (32 - bits);
+			}
+			// Returns the vertex of cell u, -1 if not found.
+			int VertexOf(int u) const;
+			// Returns the vertex of cell u, adds one if not found.
+			int AddVertex(int u);
+			void Rehash();
+		};
+
+		// SearchStats collects the counters of a single level's search (A* or flow field algorithm).
+		struct SearchStats
+		{
+			// number of vertices pushed into and popped from the priority queue.
+			std::size_t NumPushedVertices = 0;
+			std::size_t NumPoppedVertices = 0;
+			// number of popped vertices skipped since they were already visited (stale entries).
+			std::size_t NumStaleVertices = 0;
+			// number of neighbour vertices visited on expansions.
+			std::size_t NumVisitedNeighbours = 0;
+			// number of neighbour vertices rejected by the neighbour filter tester, that is, the ones
+			// not on the computed node path (or node flow field).
+			std::size_t NumFilteredNeighbours = 0;
+		};
+
+		// PathfinderStats collects the statistics of a path finding query.
+		// It's bound to a path finder on Reset(), cleared there, and then accumulated by the following
+		// Compute calls until next Reset().
+		struct PathfinderStats
+		{
+			// counters of the search on the node graph (1st level).
+			SearchStats NodeSearch;
+			// counters of the search on the gate graph (2nd level).
+			SearchStats GateSearch;
+			// number of edges created on the temporary gate graph by Reset(), connecting the start,
+			// target (and query range cells for flow field) to the existing gate cells.
+			std::size_t NumTmpEdges = 0;
+			// time cost in microseconds of each stage.
+			double ResetUs = 0;
+			double NodeStageUs = 0;	 // ComputeNodeRoutes or ComputeNodeFlowField
+			double GateStageUs = 0;	 // ComputeGateRoutes or ComputeGateFlowField
+			double FinalStageUs = 0; // ComputeFinalFlowField, only for flow field.
+		};
+
+		// StageTimer adds the elapsed microseconds since its construction to *us on destruction.
+		// Does nothing if us is nullptr.
+		class StageTimer
+		{
+		public:
+			explicit StageTimer(double* us)
+				: us(us)
+			{
+				if (us != nullptr)
+					start = std::chrono::steady_clock::now();
+			}
+			~StageTimer()
+			{
+				if (us != nullptr)
+					*us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			}
+
+		private:
+			double*								  us;
+			std::chrono::steady_clock::time_point start;
+		};
+
 		// PathFinderHelper is a mixin class to provide some util functions.
 		class PathFinderHelper
 		{
@@ -31,17 +407,14 @@ namespace QDPF
 			// Current working on map.
 			const QuadtreeMap* m = nullptr;
 			// tmp gate graph is to store edges between start/target and other gate cells.
-			SimpleUnorderedMapDirectedGraph<int> tmp;
+			TmpGraph tmp;
+
+			// Statistics of current query, optional (nullptr for disabled).
+			PathfinderStats* stats = nullptr;
 
 			// Resets current working quadtree map.
 			void Reset(const QuadtreeMap* m);
 
-			// ForEachNeighbourGateCellWithST iterates each neighbor gate cell connecting from given gate
-			// cell u. What's the deference with the gate graph's ForEachNeighbours is: it will check both
-			// the QuadtreeMap's gate cell graph and the temporary gate graph,
-			// where stores the start, target informations.
-			void ForEachNeighbourGateWithST(int u, NeighbourVertexVisitor<int>& visitor) const;
-
 			// Helper function to add a cell u to the given node on the temporary graph.
 			// it establishes bidirectional edges between u and existing gate cells inside the given node.
 			void AddCellToNodeOnTmpGraph(int u, QdNode* node);
@@ -3,8 +3,13 @@
 
 #include "QuadtreeMap.h"
 
+#include <algorithm> // for std::max
 #include <cassert>
+#include <cstddef> // for offsetof
 #include <cstdlib>
+#include <type_traits> // for std::is_standard_layout_v
+
+#include "Trace.h"
 
 namespace QDPF
 {
@@ -14,13 +19,68 @@ namespace QDPF
 		Gate::Gate(QdNode* aNode, QdNode* bNode, int a, int b)
 			: aNode(aNode), bNode(bNode), a(a), b(b) {}
 
+		// ~~~~~~~~~~~~~~~ GatePool  ~~~~~~~~~~~
+
+		Gate* GatePool::New(QdNode* aNode, QdNode* bNode, int a, int b)
+		{
+			++size;
+			if (!freeSlots.empty())
+			{
+				auto slot = freeSlots.back();
+				freeSlots.pop_back();
+				slot->gate = Gate(aNode, bNode, a, b);
+				slot->alive = true;
+				return &slot->gate;
+			}
+			if (chunks.empty() || chunks.back().size() == ChunkSize)
+			{
+				chunks.emplace_back();
+				chunks.back().reserve(ChunkSize);
+			}
+			auto& chunk = chunks.back();
+			chunk.push_back({ Gate(aNode, bNode, a, b), true });
+			return &chunk.back().gate;
+		}
+
+		void GatePool::Delete(Gate* gate)
+		{
+			// gate is the first member of a slot, so a slot shares its address.
+			static_assert(std::is_standard_layout_v<Slot>, "GatePool::Slot must be standard layout");
+			static_assert(offsetof(Slot, gate) == 0, "gate must be the first member of GatePool::Slot");
+			auto slot = reinterpret_cast<Slot*>(gate);
+			slot->alive = false;
+			freeSlots.push_back(slot);
+			--size;
+		}
+
+		void GatePool::ForEach(GateVisitor& visitor) const
+		{
+			for (const auto& chunk : chunks)
+			{
+				for (const auto& slot : chunk)
+				{
+					if (slot.alive)
+						visitor(&slot.gate);
+				}
+			}
+		}
+
+		std::size_t GatePool::MemoryBytes() const
+		{
+			std::size_t n = EstimateMemoryBytes(chunks) + EstimateMemoryBytes(freeSlots);
+			for (const auto& chunk : chunks)
+				n += EstimateMemoryBytes(chunk);
+			return n;
+		}
+
 		// ~~~~~~~~~~~~~~~ QuadtreeMap::Impl  ~~~~~~~~~~~
 
 		QuadtreeMap::QuadtreeMap(int w, int h, ObstacleChecker isObstacle, DistanceCalculator distance,
-			int step, StepFunction stepf, int maxNodeWidth, int maxNodeHeight)
+			int step, StepFunction stepf, int maxNodeWidth, int maxNodeHeight, bool implicitIntraNodeEdges)
 			: w(w), h(h), step(step), s(std::max(w, h)), // hint: checks comments for "Cell Id Packing"
 			maxNodeWidth(maxNodeWidth == -1 ? w : maxNodeWidth)
 			, maxNodeHeight(maxNodeHeight == -1 ? h : maxNodeHeight)
+			, implicitIntraNodeEdges(implicitIntraNodeEdges)
 			, isObstacle(isObstacle)
 			, distance(distance)
 			, stepf(stepf)
@@ -31,7 +91,6 @@ namespace QDPF
 
 			g1.Init();
 			g2.Init();
-			g2.Resize(s * s);
 
 			// ssf returns true to stop a quadtree node to continue to split.
 			// Where w and h are the width and height of the node's region.
@@ -51,10 +110,7 @@ namespace QDPF
 
 		QuadtreeMap::~QuadtreeMap()
 		{
-			// free all gate pointers.
-			for (auto gate : gates)
-				delete gate;
-			gates.clear();
+			// gates are freed along with the pool.
 		}
 
 		// ~~~~~~~~~~~~~~~ QuadtreeMap::Impl :: Cell Id Packing ~~~~~~~~~~~
@@ -141,7 +197,13 @@ namespace QDPF
 
 		bool QuadtreeMap::IsGateCell(QdNode* node, int u) const
 		{
-			return gates1[node][u].Size() > 0;
+			if (node == nullptr)
+				return false;
+			// a gate cell is on the gate graph, and it's a gate cell of the node containing it.
+			auto [x, y] = UnpackXY(u);
+			if (x < node->x1 || x > node->x2 || y < node->y1 || y > node->y2)
+				return false;
+			return g2.IndexOf(u) != -1;
 		}
 
 		bool QuadtreeMap::IsGateCell(int u) const
@@ -156,11 +218,23 @@ namespace QDPF
 		{
 			if (visitor == nullptr)
 				return;
-			std::function<void(Gate*)> visitor1 = [&visitor](Gate* gate) {
-				// Won't allow user to modify gate's content.
-				visitor(const_cast<const Gate*>(gate));
-			};
-			ForEachGateInNode(const_cast<QdNode*>(node), visitor1);
+			int id = NodeId(const_cast<QdNode*>(node));
+			if (id == -1)
+				return;
+			if (frozen)
+			{
+				for (int k = snapshot.GateOffsets[id]; k < snapshot.GateOffsets[id + 1]; ++k)
+					visitor(snapshot.Gates[k]);
+				return;
+			}
+			if (id >= gateCellsOfNode.size())
+				return;
+			for (auto i : gateCellsOfNode[id])
+			{
+				const auto& cg = gatesOfCell[i];
+				for (int k = 0; k < cg.n; ++k)
+					visitor(cg.gates[k]);
+			}
 		}
 
 		void QuadtreeMap::Nodes(QdNodeVisitor& visitor) const
@@ -174,19 +248,83 @@ namespace QDPF
 
 		void QuadtreeMap::Gates(GateVisitor& visitor) const
 		{
-			for (const auto& gate : gates)
-				visitor(gate);
+			gates.ForEach(visitor);
 		}
 
-		void QuadtreeMap::ForEachNeighbourNodes(QdNode* node,
-			NeighbourVertexVisitor<QdNode*>&			visitor) const
+		void QuadtreeMap::NodesInRange(const Rectangle& rect, QdNodeVisitor& visitor) const
 		{
-			g1.ForEachNeighbours(node, visitor);
+			tree.QueryLeafNodesInRange(rect.x1, rect.y1, rect.x2, rect.y2, visitor);
 		}
 
-		void QuadtreeMap::NodesInRange(const Rectangle& rect, QdNodeVisitor& visitor) const
+		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Counters ~~~~~~~~~~~~~~~~~
+
+		std::size_t QuadtreeMap::NumLeafNodes() const
 		{
-			tree.QueryLeafNodesInRange(rect.x1, rect.y1, rect.x2, rect.y2, visitor);
+			std::size_t	  n = 0;
+			QdNodeVisitor visitor = [&n](QdNode* node) { ++n; };
+			Nodes(visitor);
+			return n;
+		}
+
+		QuadtreeMapStats QuadtreeMap::Stats() const
+		{
+			QuadtreeMapStats stats;
+
+			// the tree nodes, and the obstacles stored in leaf nodes.
+			QdTree::VisitorT treeVisitor = [&stats](QdNode* node) {
+				using Object = decltype(node->objects)::value_type;
+				++stats.Tree.NumEntries;
+				stats.Tree.Bytes += sizeof(QdNode) + node->objects.size() * HashNodeBytes<Object>;
+				if (!node->isLeaf)
+					return;
+				++stats.NumLeafNodes;
+				if (node->objects.size())
+					++stats.NumObstacleLeafNodes;
+			};
+			tree.ForEachNode(treeVisitor);
+
+			stats.NodeGraph = { g1.NumEdges(), g1.MemoryBytes() };
+			stats.GateGraph = { g2.NumEdges(), g2.MemoryBytes() };
+			stats.Gates = { gates.Size(), gates.MemoryBytes() };
+			if (frozen)
+				stats.Snapshot = { snapshot.NodeGraph.NumEdges() + snapshot.GateGraph.NumEdges(),
+					snapshot.MemoryBytes() };
+			if (numLandmarks > 0)
+				stats.Landmarks = { landmarks1.NumEntries() + landmarks2.NumEntries(),
+					landmarks1.MemoryBytes() + landmarks2.MemoryBytes() + EstimateMemoryBytes(touchedNodeIds)
+						+ EstimateMemoryBytes(touchedGateCells) };
+			stats.Hierarchy = { hierarchy.NumEdges(), hierarchy.MemoryBytes() };
+			if (oracleMaxSize > 0)
+				stats.NodeDistances = { oracle.NumEntries(),
+					oracle.MemoryBytes() + EstimateMemoryBytes(oracleTouchedNodeIds) };
+			stats.Gates1.Bytes = EstimateMemoryBytes(gatesOfCell) + EstimateMemoryBytes(gateCellsOfNode);
+			for (const auto& cells : gateCellsOfNode)
+				stats.Gates1.Bytes += EstimateMemoryBytes(cells);
+
+			// gates per node and out-degree per gate cell.
+			std::size_t					degree = 0;
+			NeighbourVertexVisitor<int> degreeCounter = [&degree](int v, int cost) { ++degree; };
+
+			QdNodeVisitor nodeVisitor = [this, &stats, &degree, &degreeCounter](QdNode* node) {
+				if (node->objects.size())
+					return;
+				std::size_t numGates = 0;
+				int			id = NodeId(node);
+				if (id != -1 && id < gateCellsOfNode.size())
+				{
+					for (auto i : gateCellsOfNode[id])
+					{
+						numGates += gatesOfCell[i].n;
+						++stats.Gates1.NumEntries;
+						degree = 0;
+						ForEachNeighbourGateCellIndexes(i, degreeCounter);
+						stats.OutDegreePerGateCell.Add(degree);
+					}
+				}
+				stats.GatesPerNode.Add(numGates);
+			};
+			Nodes(nodeVisitor);
+			return stats;
 		}
 
 		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Graphs Maintaining ~~~~~~~~~~~~~~~~~
@@ -254,20 +392,222 @@ namespace QDPF
 			}
 		}
 
+		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Snapshot ~~~~~~~~~~~~~~~~~
+
+		std::size_t QuadtreeMapSnapshot::MemoryBytes() const
+		{
+			return NodeGraph.MemoryBytes() + GateGraph.MemoryBytes() + EstimateMemoryBytes(GateCellOffsets)
+				+ EstimateMemoryBytes(GateCells) + EstimateMemoryBytes(GateOffsets)
+				+ EstimateMemoryBytes(Gates) + EstimateMemoryBytes(NodeOfGateCell);
+		}
+
+		void QuadtreeMap::Freeze()
+		{
+			QDPF_TRACE_SCOPE("QuadtreeMap::Freeze");
+
+			snapshot.NodeGraph.Build(g1);
+			snapshot.GateGraph.Build(g2);
+
+			// flattens the gates index by node ids.
+			int numNodeIds = g1.NumIndexes();
+			snapshot.GateCellOffsets.assign(numNodeIds + 1, 0);
+			snapshot.GateOffsets.assign(numNodeIds + 1, 0);
+			snapshot.GateCells.clear();
+			snapshot.Gates.clear();
+			snapshot.NodeOfGateCell.assign(g2.NumIndexes(), -1);
+			for (int id = 0; id < numNodeIds; ++id)
+			{
+				if (id < gateCellsOfNode.size())
+				{
+					for (auto i : gateCellsOfNode[id])
+					{
+						snapshot.GateCells.push_back(i);
+						snapshot.NodeOfGateCell[i] = id;
+						const auto& cg = gatesOfCell[i];
+						snapshot.Gates.insert(snapshot.Gates.end(), cg.gates, cg.gates + cg.n);
+					}
+				}
+				snapshot.GateCellOffsets[id + 1] = snapshot.GateCells.size();
+				snapshot.GateOffsets[id + 1] = snapshot.Gates.size();
+			}
+			frozen = true;
+		}
+
+		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Landmarks ~~~~~~~~~~~~~~~~~
+
+		void QuadtreeMap::BuildLandmarks(int k)
+		{
+			QDPF_TRACE_SCOPE("QuadtreeMap::BuildLandmarks");
+
+			numLandmarks = std::max(k, 0);
+			touchedNodeIds.clear(), touchedGateCells.clear();
+			if (numLandmarks == 0)
+			{
+				landmarks1 = Landmarks{}, landmarks2 = Landmarks{};
+				return;
+			}
+			landmarks1.Build(
+				numLandmarks, g1.NumIndexes(), [this](int id) { return g1.VertexAt(id) != nullptr; },
+				[this](int id, auto& visitor) { ForEachNeighbourNodeIds(id, visitor); });
+			landmarks2.Build(
+				numLandmarks, g2.NumIndexes(), [this](int i) { return g2.VertexAt(i) != -1; },
+				[this](int i, auto& visitor) { ForEachNeighbourGateCellIndexes(i, visitor); });
+		}
+
+		void QuadtreeMap::RepairLandmarks()
+		{
+			QDPF_TRACE_SCOPE("QuadtreeMap::RepairLandmarks");
+
+			if (numLandmarks == 0)
+				return;
+			landmarks1.Repair(
+				g1.NumIndexes(), touchedNodeIds, [this](int id) { return g1.VertexAt(id) != nullptr; },
+				[this](int id, auto& visitor) { ForEachNeighbourNodeIds(id, visitor); });
+			landmarks2.Repair(
+				g2.NumIndexes(), touchedGateCells, [this](int i) { return g2.VertexAt(i) != -1; },
+				[this](int i, auto& visitor) { ForEachNeighbourGateCellIndexes(i, visitor); });
+			touchedNodeIds.clear(), touchedGateCells.clear();
+		}
+
+		void QuadtreeMap::TouchNodeId(int id)
+		{
+			if (numLandmarks > 0)
+				touchedNodeIds.push_back(id);
+			if (oracleMaxSize > 0)
+				oracleTouchedNodeIds.push_back(id);
+		}
+
+		void QuadtreeMap::TouchGateCell(int i)
+		{
+			if (numLandmarks > 0)
+				touchedGateCells.push_back(i);
+		}
+
+		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Contraction Hierarchy ~~~~~~~~~~~~~~~~~
+
+		void QuadtreeMap::BuildContractionHierarchy()
+		{
+			if (hierarchyUpToDate)
+				return;
+			QDPF_TRACE_SCOPE("QuadtreeMap::BuildContractionHierarchy");
+
+			hierarchyBuilt = hierarchy.Build(
+				g2.NumIndexes(), [this](int i) { return g2.VertexAt(i) != -1; },
+				[this](int i, auto& visitor) { ForEachNeighbourGateCellIndexes(i, visitor); });
+			hierarchyUpToDate = true;
+		}
+
+		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Node Distance Oracle ~~~~~~~~~~~~~~~~~
+
+		void QuadtreeMap::BuildNodeDistanceOracle(int maxSize)
+		{
+			QDPF_TRACE_SCOPE("QuadtreeMap::BuildNodeDistanceOracle");
+
+			maxSize = std::max(maxSize, 0);
+			if (maxSize > 0 && maxSize == oracleMaxSize)
+			{
+				// repairs the changes since, the unchanged tables are kept.
+				RepairNodeDistanceOracle();
+				return;
+			}
+			oracleMaxSize = maxSize;
+			oracleTouchedNodeIds.clear();
+			if (oracleMaxSize == 0)
+			{
+				oracle = DistanceOracle{};
+				return;
+			}
+			oracle.Build(
+				oracleMaxSize, g1.NumIndexes(), [this](int id) { return g1.VertexAt(id) != nullptr; },
+				[this](int id, auto& visitor) { ForEachNeighbourNodeIds(id, visitor); });
+		}
+
+		void QuadtreeMap::RepairNodeDistanceOracle()
+		{
+			QDPF_TRACE_SCOPE("QuadtreeMap::RepairNodeDistanceOracle");
+
+			if (oracleMaxSize == 0)
+				return;
+			auto neighbours = [this](int id, auto& visitor) { ForEachNeighbourNodeIds(id, visitor); };
+			oracle.Repair(
+				g1.NumIndexes(), oracleTouchedNodeIds, [this](int id) { return g1.VertexAt(id) != nullptr; },
+				neighbours);
+			oracle.ComputeDropped(neighbours);
+			oracleTouchedNodeIds.clear();
+		}
+
 		// ~~~~~~~~~~~~~ QuadtreeMap::Impl :: Internals ~~~~~~~~~~~~~~~~~
 
 		// visits each gate of a given node.
 		void QuadtreeMap::ForEachGateInNode(QdNode* node, std::function<void(Gate*)>& visitor) const
 		{
-			if (gates1[node].Size() == 0)
+			int id = NodeId(node);
+			if (id == -1 || id >= gateCellsOfNode.size())
 				return;
-			for (auto& [a, m] : gates1[node].GetUnderlyingUnorderedMap())
-			{ // gates1[aNode][a]
-				for (auto& [b, gate] : m.GetUnderlyingUnorderedMap())
-				{ // gates1[aNode][a][b]
-					visitor(gate);
-				}
+			for (auto i : gateCellsOfNode[id])
+			{
+				const auto& cg = gatesOfCell[i];
+				for (int k = 0; k < cg.n; ++k)
+					visitor(cg.gates[k]);
+			}
+		}
+
+		// Returns the gate from cell a to b, nullptr if not exist.
+		Gate* QuadtreeMap::FindGate(int a, int b) const
+		{
+			int i = g2.IndexOf(a);
+			if (i == -1)
+				return nullptr;
+			const auto& cg = gatesOfCell[i];
+			for (int k = 0; k < cg.n; ++k)
+			{
+				if (cg.gates[k]->b == b)
+					return cg.gates[k];
 			}
+			return nullptr;
+		}
+
+		// Adds a new gate cell a inside aNode, to the gate graph and the gates index.
+		void QuadtreeMap::AddGateCell(QdNode* aNode, int a)
+		{
+			// aNode is already on the node graph, AddVertex just returns its id.
+			int id = g1.AddVertex(aNode), i = g2.AddVertex(a);
+			if (id >= gateCellsOfNode.size())
+				gateCellsOfNode.resize(id + 1);
+			if (i >= gatesOfCell.size())
+				gatesOfCell.resize(i + 1);
+			auto& cells = gateCellsOfNode[id];
+			gatesOfCell[i].n = 0;
+			gatesOfCell[i].pos = cells.size();
+			gatesOfCell[i].node = id;
+			cells.push_back(i);
+			TouchGateCell(i);
+		}
+
+		// Removes given gate cell a inside aNode, when it's no longer a gate cell.
+		// All edges connecting with a are removed, and its gate cell index is recycled.
+		void QuadtreeMap::RemoveGateCell(QdNode* aNode, int a)
+		{
+			int	  id = NodeId(aNode), i = g2.IndexOf(a);
+			auto& cells = gateCellsOfNode[id];
+			// for the landmarks, the neighbours lose their edges to it.
+			if (numLandmarks > 0)
+			{
+				TouchGateCell(i);
+				ForEachNeighbourGateCellIndexes(i, [this](int j, int cost) { TouchGateCell(j); });
+			}
+			// removes i from the node's list, moves the last one to its position.
+			int pos = gatesOfCell[i].pos;
+			if (pos != cells.size() - 1)
+			{
+				cells[pos] = cells.back();
+				gatesOfCell[cells[pos]].pos = pos;
+			}
+			cells.pop_back();
+			gatesOfCell[i].n = 0;
+			gatesOfCell[i].pos = -1;
+			gatesOfCell[i].node = -1;
+			g2.RemoveVertex(a);
 		}
 
 		// Connects given two cells in the gate graphs by establishing bidirectional edges between them.
@@ -281,10 +621,14 @@ namespace QDPF
 		// Connects bidirectional edges between the new gate cell a and all other existing gate cells in
 		// this node. The given node must not be an obstacle node. Hint: all cells inside a non-obstacle
 		// node are reachable to each other.
+		// Does nothing in the implicitIntraNodeEdges mode, these edges are generated on the fly.
 		void QuadtreeMap::ConnectGateCellsInNodeToNewGateCell(QdNode* aNode, int a)
 		{
-			for (auto& [u, m] : gates1[aNode].GetUnderlyingUnorderedMap())
+			if (implicitIntraNodeEdges)
+				return;
+			for (auto i : gateCellsOfNode[NodeId(aNode)])
 			{
+				auto u = g2.VertexAt(i);
 				if (u != a)
 					ConnectCellsInGateGraphs(u, a);
 			}
@@ -300,55 +644,64 @@ namespace QDPF
 		// 2. Connects a and b and add the created gate into management.
 		void QuadtreeMap::CreateGate(QdNode* aNode, int a, QdNode* bNode, int b)
 		{
-			// idempotent: if aNode[a][b] => bNode exist
-			auto gt1 = gates1[aNode][a][b];
-			if (gt1 != nullptr && gt1->bNode == bNode)
-				return;
-
-			// idempotent: if bNode[b][a] => aNode exist
-			auto gt2 = gates1[bNode][b][a];
-			if (gt2 != nullptr && gt2->bNode == aNode)
+			// idempotent: if a => b exist (the dual gates are always created and removed together).
+			if (FindGate(a, b) != nullptr)
 				return;
 
 			// bidirection edges between new gate cell and existing gate cells inside each node.
-			ConnectGateCellsInNodeToNewGateCell(aNode, a);
-			ConnectGateCellsInNodeToNewGateCell(bNode, b);
+			// An existing gate cell is already connected to the others in its node, and the gate graph
+			// doesn't check duplicate edges.
+			// A new gate cell is added to the gate graph, which allocates its gate cell index.
+			if (g2.IndexOf(a) == -1)
+			{
+				AddGateCell(aNode, a);
+				ConnectGateCellsInNodeToNewGateCell(aNode, a);
+			}
+			if (g2.IndexOf(b) == -1)
+			{
+				AddGateCell(bNode, b);
+				ConnectGateCellsInNodeToNewGateCell(bNode, b);
+			}
 
 			// connects a and b.
 			ConnectCellsInGateGraphs(a, b);
+			// for the landmarks, touching one end of a new edge is enough (see Landmarks::Repair).
+			TouchGateCell(g2.IndexOf(a));
 
-			// creates a gate and maintain into container gates and gates.
-			auto gate1 = new Gate(aNode, bNode, a, b); // a => b
-			auto gate2 = new Gate(bNode, aNode, b, a); // b => a
-
-			gates.insert(gate1);
-			gates.insert(gate2);
-
-			gates1[aNode][a][b] = gate1;
-			gates1[bNode][b][a] = gate2;
-		}
+			// creates a gate and maintain into container gates and gatesOfCell.
+			auto gate1 = gates.New(aNode, bNode, a, b); // a => b
+			auto gate2 = gates.New(bNode, aNode, b, a); // b => a
 
-		// Disconnects all edges connecting with given gate cell u.
-		void QuadtreeMap::DisconnectCellInGateGraphs(int u)
-		{
-			g2.ClearEdgeTo(u);
-			g2.ClearEdgeFrom(u);
+			auto& ag = gatesOfCell[g2.IndexOf(a)];
+			auto& bg = gatesOfCell[g2.IndexOf(b)];
+			ag.gates[ag.n++] = gate1;
+			bg.gates[bg.n++] = gate2;
 		}
 
 		//  Connects given two nodes on the node graph.
+		// A pair of nodes may be met more than once, e.g. a neighbour both at a side and a corner.
 		void QuadtreeMap::ConnectNodesOnNodeGraph(QdNode* aNode, QdNode* bNode)
 		{
+			if (g1.HasEdge(aNode, bNode))
+				return;
 			// use the distance betwen the two nodes's center cells
 			int dist = DistanceBetweenNodes(aNode, bNode);
 			g1.AddEdge(aNode, bNode, dist);
 			g1.AddEdge(bNode, aNode, dist);
 		}
 
-		// Disconnects the given node from the node graphs.
-		void QuadtreeMap::DisconnectNodeFromNodeGraph(QdNode* aNode)
+		// Removes the given node from the node graph, along with all edges connecting with it.
+		// Its node id is recycled.
+		void QuadtreeMap::RemoveNodeFromNodeGraph(QdNode* aNode)
 		{
-			g1.ClearEdgeTo(aNode);
-			g1.ClearEdgeFrom(aNode);
+			// for the landmarks and the oracle, the neighbours lose their edges to it.
+			if (numLandmarks > 0 || oracleMaxSize > 0)
+			{
+				int id = NodeId(aNode);
+				TouchNodeId(id);
+				ForEachNeighbourNodeIds(id, [this](int j, int cost) { TouchNodeId(j); });
+			}
+			g1.RemoveVertex(aNode);
 		}
 
 		// Handle the node graph and all gate graphs changes on a quadtree node is removed.
@@ -357,16 +710,30 @@ namespace QDPF
 		// 3. (gates) Remove all gates inside the node.
 		void QuadtreeMap::HandleRemovedNode(QdNode* aNode)
 		{
-			DisconnectNodeFromNodeGraph(aNode);
+			QDPF_TRACE_SCOPE("QuadtreeMap::HandleRemovedNode");
+
+			++numRemovedNodesHandled;
+			frozen = false;
+			hierarchyUpToDate = false;
+
+			// obstacle nodes have no gates, and aren't on the node graph.
+			int id = NodeId(aNode);
+			if (id == -1)
+				return;
 
 			// we first collect all gates in this node.
 			std::vector<Gate*>		   aNodeGates;
 			std::function<void(Gate*)> visitor = [&aNodeGates](Gate* gate) { aNodeGates.push_back(gate); };
 			ForEachGateInNode(aNode, visitor);
 
-			// for each gate cell a inside aNode, disconnect a from the gate graph.
-			for (auto gate : aNodeGates)
-				DisconnectCellInGateGraphs(gate->a);
+			// for each gate cell a inside aNode, remove a from the gate graph.
+			// removes from the back, no cells are moved.
+			if (id < gateCellsOfNode.size())
+			{
+				auto& cells = gateCellsOfNode[id];
+				while (!cells.empty())
+					RemoveGateCell(aNode, g2.VertexAt(cells.back()));
+			}
 
 			// remove the dual gate in each adjacent node b.
 			for (const auto aGate : aNodeGates)
@@ -374,33 +741,35 @@ namespace QDPF
 				auto a = aGate->a, b = aGate->b;
 				auto bNode = aGate->bNode;
 
-				auto bGate = gates1[bNode][b][a];
-
-				// remove bGate from bNode.
-				gates1[bNode][b].Erase(a);
-				gates.erase(bGate);
-				delete bGate;
-
-				// shrink the unordered_maps if empty.
-				if (gates1[bNode][b].Size() == 0)
+				// remove bGate (b => a) from b, moves the last one to its position.
+				// b isn't a gate cell if it's already removed along with its gates.
+				int i = g2.IndexOf(b);
+				if (i == -1)
+					continue;
+				auto& bg = gatesOfCell[i];
+				for (int k = 0; k < bg.n; ++k)
 				{
-					// that is, b is the gate cell which only points to a.
-					// disconncts it from the gate graph.
-					DisconnectCellInGateGraphs(b);
-					gates1[bNode].Erase(b);
+					if (bg.gates[k]->b == a)
+					{
+						gates.Delete(bg.gates[k]);
+						bg.gates[k] = bg.gates[--bg.n];
+						break;
+					}
 				}
 
-				if (gates1[bNode].Size() == 0)
-					gates1.Erase(bNode);
+				// that is, b is the gate cell which only points to a.
+				// removes it from the gate graph.
+				if (bg.n == 0)
+					RemoveGateCell(bNode, b);
 			}
 
 			// remove all gates inside aNode.
 			for (auto gate : aNodeGates)
 			{
-				gates.erase(gate);
-				delete gate;
+				gates.Delete(gate);
 			}
-			gates1.Erase(aNode);
+
+			RemoveNodeFromNodeGraph(aNode);
 		}
 
 		// Handle the node graph and all gate graphs changes on a quadtree node is created.
@@ -409,10 +778,19 @@ namespace QDPF
 		// 3. and finally establish the edges in all graphs.
 		void QuadtreeMap::HandleNewNode(QdNode* aNode)
 		{
+			QDPF_TRACE_SCOPE("QuadtreeMap::HandleNewNode");
+
+			++numNewNodesHandled;
+			frozen = false;
+			hierarchyUpToDate = false;
+
 			// ignores if it's a obstacle node.
 			if (aNode->objects.size())
 				return;
 
+			// assigns the node id, even if it's isolated.
+			TouchNodeId(g1.AddVertex(aNode));
+
 			// ~~~~~~ find neighbours nodes ~~~~~~~
 
 			// format: neighbours[direction] => list of neighbour nodes
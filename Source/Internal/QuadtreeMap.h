@@ -7,7 +7,10 @@
 #include <functional> // for std::function
 
 #include "Base.h"
+#include "ContractionHierarchy.h"
+#include "DistanceOracle.h"
 #include "Graph.h"
+#include "Landmarks.h"
 #include "Quadtree-hpp/Source/Quadtree.hpp"
 
 // QuadtreeMap
@@ -54,11 +57,115 @@ namespace QDPF
 		// GateVisitor the type of the function to visit gates.
 		using GateVisitor = std::function<void(const Gate*)>;
 
-		// Graph of gate cells.
-		using GateGraph = SimpleDirectedGraph;
+		// GatePool manages the memory of gates.
+		// Gates are stored in fixed-size chunks, so their addresses are stable, and the slots of freed
+		// gates are reused by a free list. Chunks are never released until the pool is destroyed, so
+		// terrain changes don't allocate or free a gate at a time.
+		class GatePool
+		{
+		public:
+			// Creates a gate, returns its stable address.
+			Gate* New(QdNode* aNode, QdNode* bNode, int a, int b);
+
+			// Frees a gate created by New.
+			void Delete(Gate* gate);
 
-		// Graph of nodes.
-		using NodeGraph = SimpleUnorderedMapDirectedGraph<QdNode*>;
+			// Visit each live gate.
+			void ForEach(GateVisitor& visitor) const;
+
+			// Returns the number of live gates.
+			std::size_t Size() const { return size; }
+
+			// Returns the estimated heap bytes of the pool.
+			std::size_t MemoryBytes() const;
+
+		private:
+			// number of gates of each chunk.
+			static const int ChunkSize = 1024;
+
+			// a gate slot, alive is false for a freed slot.
+			struct Slot
+			{
+				Gate gate;
+				bool alive;
+			};
+
+			// each chunk is reserved to ChunkSize, and never reallocated.
+			std::vector<std::vector<Slot>> chunks;
+			// freed slots to reuse.
+			std::vector<Slot*> freeSlots;
+			std::size_t		   size = 0;
+		};
+
+		// Graph of gate cells, only gate cells are stored.
+		// In the implicitIntraNodeEdges mode, only the edges crossing nodes are stored.
+		using GateGraph = SparseDirectedGraph<int, -1>;
+
+		// Graph of nodes, only non-obstacle leaf nodes are stored.
+		using NodeGraph = SparseDirectedGraph<QdNode*, nullptr>;
+
+		// QuadtreeMapStats is the memory usage and topology statistics of a quadtree map.
+		// The bytes are estimated heap bytes, the allocator's overhead is not included.
+		struct QuadtreeMapStats
+		{
+			// ~~~~~~~~~~~~~ Memory ~~~~~~~~~~~~~~
+			// the quadtree, entries are all the tree nodes (leaf or not).
+			MemoryUsage Tree;
+			// the node graph, entries are directed edges.
+			MemoryUsage NodeGraph;
+			// the gate graph, entries are directed edges.
+			MemoryUsage GateGraph;
+			// the gate objects along with the pool managing them, entries are gates.
+			MemoryUsage Gates;
+			// the gates index (gate cells of each node, gates of each gate cell), entries are gate cells.
+			MemoryUsage Gates1;
+			// the snapshot (see QuadtreeMap::Freeze), entries are directed edges of both graphs.
+			MemoryUsage Snapshot;
+			// the landmarks tables (see QuadtreeMap::BuildLandmarks), entries are distances stored.
+			MemoryUsage Landmarks;
+			// the contraction hierarchy (see QuadtreeMap::BuildContractionHierarchy), entries are upward
+			// edges (including shortcuts).
+			MemoryUsage Hierarchy;
+			// the node distance tables (see QuadtreeMap::BuildNodeDistanceOracle), entries are distances
+			// stored.
+			MemoryUsage NodeDistances;
+
+			// Returns the sum of bytes of all the parts above.
+			std::size_t TotalBytes() const
+			{
+				return Tree.Bytes + NodeGraph.Bytes + GateGraph.Bytes + Gates.Bytes + Gates1.Bytes
+					+ Snapshot.Bytes + Landmarks.Bytes + Hierarchy.Bytes + NodeDistances.Bytes;
+			}
+
+			// ~~~~~~~~~~~~~ Topology ~~~~~~~~~~~~~~
+			// number of leaf nodes, and how many of them are obstacle nodes.
+			std::size_t NumLeafNodes = 0, NumObstacleLeafNodes = 0;
+			// number of gates inside each non-obstacle leaf node.
+			Histogram GatesPerNode;
+			// number of out edges of each gate cell on the gate graph.
+			Histogram OutDegreePerGateCell;
+		};
+
+		// QuadtreeMapSnapshot is an immutable, read-optimized copy of the graphs and the gates index of a
+		// quadtree map, built by QuadtreeMap::Freeze(). All parts are flat arrays, indexed by the node
+		// ids and gate cell indexes.
+		struct QuadtreeMapSnapshot
+		{
+			// the node graph, on node ids.
+			FrozenDirectedGraph NodeGraph;
+			// the gate graph, on gate cell indexes.
+			FrozenDirectedGraph GateGraph;
+			// the gate cells inside node i are GateCells[GateCellOffsets[i]..GateCellOffsets[i+1]).
+			std::vector<int> GateCellOffsets, GateCells;
+			// the gates inside node i are Gates[GateOffsets[i]..GateOffsets[i+1]).
+			std::vector<int>		 GateOffsets;
+			std::vector<const Gate*> Gates;
+			// NodeOfGateCell[gate cell index] => node id.
+			std::vector<int> NodeOfGateCell;
+
+			// Returns the estimated heap bytes of the snapshot.
+			std::size_t MemoryBytes() const;
+		};
 
 		// QuadtreeMap is a 2D map maintained by a quadtree.
 		// QuadtreeMap is nothing to do with agent size and terrain types.
@@ -66,7 +173,8 @@ namespace QDPF
 		{
 		public:
 			QuadtreeMap(int w, int h, ObstacleChecker isObstacle, DistanceCalculator distance, int step = 1,
-				StepFunction stepf = nullptr, int maxNodeWidth = -1, int maxNodeHeight = -1);
+				StepFunction stepf = nullptr, int maxNodeWidth = -1, int maxNodeHeight = -1,
+				bool implicitIntraNodeEdges = false);
 			~QuadtreeMap();
 
 			// ~~~~~~~~~~~~~~~ Cell ID Packing ~~~~~~~~~~~
@@ -100,11 +208,86 @@ namespace QDPF
 			int DistanceBetweenNodes(QdNode* aNode, QdNode* bNode) const;
 
 			// Returns the gates's graph.
+			// Note that the edges inside nodes aren't stored in the implicitIntraNodeEdges mode, use
+			// ForEachNeighbourGateCells to visit all the neighbours of a gate cell.
 			const GateGraph& GetGateGraph() const { return g2; }
 
+			// Returns true if the edges between gate cells inside a node are generated on the fly.
+			bool IsImplicitIntraNodeEdges() const { return implicitIntraNodeEdges; }
+
+			// ~~~~~~~~~~~~~ Snapshot ~~~~~~~~~~~~~~~~~
+
+			// Freeze builds a read-optimized snapshot of the node graph, the gate graph and the gates
+			// index (see QuadtreeMapSnapshot). The visits and reads below (that the path finders use) read
+			// from the snapshot instead, until the map is changed.
+			// Any quadtree node change invalidates the snapshot, call Freeze again after the changes.
+			void Freeze();
+
+			// Returns the snapshot, nullptr if it's not frozen or changed since the last Freeze().
+			const QuadtreeMapSnapshot* Snapshot() const { return frozen ? &snapshot : nullptr; }
+
 			// Returns the nodes's graph.
 			const NodeGraph& GetNodeGraph() const { return g1; }
 
+			// ~~~~~~~~~~~~~ Landmarks ~~~~~~~~~~~~~~~~~
+
+			// BuildLandmarks picks k landmarks on the node graph and k on the gate graph, and computes the
+			// exact distances from them (see Landmarks). The path finders use them as a tighter heuristic.
+			// k = 0 drops the landmarks.
+			// Any graph change makes the landmarks stale, call RepairLandmarks after the changes.
+			void BuildLandmarks(int k);
+
+			// Repairs the landmarks after the graphs are changed, only the distances affected by the
+			// changed nodes are computed again. Does nothing if the landmarks aren't built.
+			void RepairLandmarks();
+
+			// Returns the landmarks on the node graph (by node ids), nullptr if they aren't built or the
+			// map is changed since the last repair.
+			const Landmarks* NodeLandmarks() const { return LandmarksUpToDate() ? &landmarks1 : nullptr; }
+
+			// Returns the landmarks on the gate graph (by gate cell indexes), nullptr if they aren't built
+			// or the map is changed since the last repair.
+			const Landmarks* GateLandmarks() const { return LandmarksUpToDate() ? &landmarks2 : nullptr; }
+
+			// ~~~~~~~~~~~~~ Contraction Hierarchy ~~~~~~~~~~~~~~~~~
+
+			// BuildContractionHierarchy builds a contraction hierarchy index on the gate graph (see
+			// ContractionHierarchy), the gate routes without a node path are then computed on it.
+			// It takes much longer than a search to build, for static maps. Does nothing if the map isn't
+			// changed since the last build.
+			// Any quadtree node change invalidates the index, the path finders search on the graphs
+			// instead, until it's built again. So do they if the build gives up on a graph without
+			// bottlenecks (see ContractionHierarchy::Build).
+			void BuildContractionHierarchy();
+
+			// Returns the index on the gate graph (by gate cell indexes), nullptr if it's not built (or
+			// given up) or the map is changed since the last build.
+			const ContractionHierarchy* GateHierarchy() const
+			{
+				return hierarchyUpToDate && hierarchyBuilt ? &hierarchy : nullptr;
+			}
+
+			// ~~~~~~~~~~~~~ Node Distance Oracle ~~~~~~~~~~~~~~~~~
+
+			// BuildNodeDistanceOracle computes the distances and next hops between all pairs of nodes on
+			// the node graph (see DistanceOracle), for each connected component of at most maxSize nodes.
+			// The node routes are then walked on the tables instead of searched. maxSize = 0 drops it.
+			// Calling it again with the same maxSize repairs it.
+			// Any graph change makes it stale, call RepairNodeDistanceOracle after the changes.
+			void BuildNodeDistanceOracle(int maxSize);
+
+			// Labels the components again after the graphs are changed, and computes the tables of the
+			// components with changed nodes again, if they are of at most maxSize nodes. The other
+			// tables are kept. Does nothing if the oracle isn't built.
+			void RepairNodeDistanceOracle();
+
+			// Returns the oracle on the node graph (by node ids), nullptr if it's not built or the map is
+			// changed since the last repair.
+			const DistanceOracle* NodeDistanceOracle() const
+			{
+				return oracleMaxSize > 0 && oracleTouchedNodeIds.empty() ? &oracle : nullptr;
+			}
+
 			// ~~~~~~~~~~~~~ Visits and Reads ~~~~~~~~~~~~~~~~~
 
 			// Get the quadtree node where the given cell (x,y) locates.
@@ -118,9 +301,44 @@ namespace QDPF
 			// higher level version method based on IsGateCell(node, u).
 			bool IsGateCell(int u) const;
 
+			// Returns the dense index of gate cell u, -1 if u is not a gate cell.
+			// A gate cell's index is stable until it's no longer a gate cell, and the indexes of removed
+			// gate cells are recycled, so they are always small: [0, NumGateCellIndexes()).
+			// Search states can be stored in flat arrays indexed by them.
+			int GateCellIndex(int u) const { return g2.IndexOf(u); }
+
+			// Returns the gate cell of given dense index, -1 if the index is not in use.
+			int GateCellAt(int i) const { return g2.VertexAt(i); }
+
+			// Returns the upper bound (exclusive) of the dense indexes of gate cells.
+			int NumGateCellIndexes() const { return g2.NumIndexes(); }
+
+			// Returns the id of given leaf node, -1 if it's an obstacle node (or not a leaf node).
+			// A node's id is stable until the node is removed, and the ids of removed nodes are recycled,
+			// so they are always small: [0, NumNodeIds()).
+			// Search states can be stored in flat arrays indexed by them.
+			int NodeId(QdNode* node) const { return g1.IndexOf(node); }
+
+			// Returns the leaf node of given id, nullptr if the id is not in use.
+			QdNode* NodeAt(int id) const { return g1.VertexAt(id); }
+
+			// Returns the upper bound (exclusive) of the node ids.
+			int NumNodeIds() const { return g1.NumIndexes(); }
+
 			// Visit each gate cell inside a node and call given visitor with it.
 			void ForEachGateInNode(const QdNode* node, GateVisitor& visitor) const;
 
+			// Visit the neighbour gate cells of gate cell u on the gate graph, along with the costs.
+			// In the implicitIntraNodeEdges mode, the other gate cells in u's node are visited as well.
+			// Does nothing if u is not a gate cell.
+			// The visitor is any callable of signature void(int v, int cost), so it can be inlined.
+			template <typename Visitor>
+			void ForEachNeighbourGateCells(int u, Visitor&& visitor) const;
+
+			// The same to ForEachNeighbourGateCells, but on gate cell indexes.
+			template <typename Visitor>
+			void ForEachNeighbourGateCellIndexes(int i, Visitor&& visitor) const;
+
 			// Visit all the quadtree's leaf nodes.
 			void Nodes(QdNodeVisitor& visitor) const;
 
@@ -129,7 +347,13 @@ namespace QDPF
 			void Gates(GateVisitor& visitor) const;
 
 			// Visit reachable neighbor nodes for given node on the node graph.
-			void ForEachNeighbourNodes(QdNode* node, NeighbourVertexVisitor<QdNode*>& visitor) const;
+			// The visitor is any callable of signature void(QdNode* v, int cost).
+			template <typename Visitor>
+			void ForEachNeighbourNodes(QdNode* node, Visitor&& visitor) const;
+
+			// Visit reachable neighbor nodes for given node id on the node graph, by node ids.
+			template <typename Visitor>
+			void ForEachNeighbourNodeIds(int id, Visitor&& visitor) const;
 
 			// Visit quadtree nodes inside given rectangle range.
 			void NodesInRange(const Rectangle& rect, QdNodeVisitor& visitor) const;
@@ -143,10 +367,30 @@ namespace QDPF
 			// Update should be called after any cell (x,y)'s value is changed.
 			void Update(int x, int y);
 
+			// ~~~~~~~~~~~~~ Counters ~~~~~~~~~~~~~~~~~
+
+			// Returns the number of leaf nodes of the quadtree.
+			std::size_t NumLeafNodes() const;
+
+			// Returns the number of gates.
+			// Note that dual gates (a => b) and (b => a) are counted twice (once for each).
+			std::size_t NumGates() const { return gates.Size(); }
+
+			// Returns the number of leaf node creations handled since construction.
+			std::size_t NumNewNodesHandled() const { return numNewNodesHandled; }
+
+			// Returns the number of leaf node removals handled since construction.
+			std::size_t NumRemovedNodesHandled() const { return numRemovedNodesHandled; }
+
+			// Collects the memory usage and topology statistics.
+			// It walks all the nodes and gates, don't call it in a hot path.
+			QuadtreeMapStats Stats() const;
+
 		private:
 			const int w, h, step;
 			const int s; // max side of (w,h)
 			const int maxNodeWidth, maxNodeHeight;
+			const bool implicitIntraNodeEdges;
 
 			ObstacleChecker	   isObstacle;
 			DistanceCalculator distance;
@@ -157,23 +401,76 @@ namespace QDPF
 
 			// ~~~~~~~~~~~~~~~ Graphs ~~~~~~~~~~~
 			// the 1st level abstract graph: graph of nodes.
+			// its vertices are maintained by HandleNewNode and HandleRemovedNode, they are exactly the
+			// non-obstacle leaf nodes, and their dense indexes are the node ids.
 			NodeGraph g1;
 			// the 2st level abstract graph: graph of gate cells.
+			// its vertices are maintained by CreateGate and HandleRemovedNode, they are exactly the gate
+			// cells, and their dense indexes are the gate cell indexes.
 			GateGraph g2;
 
 			// ~~~~~~~~~~~~~~ Gates ~~~~~~~~~~~~~
 			// manages memory of gates.
-			std::unordered_set<Gate*> gates;
-			// gates group by node for faster quering.
-			// gates1[aNode][a][b] => Gate*
-			// there may exist 1~3 gates starting from a cell.
-			// for an example below, the 3 gates are:
+			GatePool gates;
+			// gates group by gate cell for faster quering.
+			// there may exist 1~3 gates starting from a cell, e.g. for the example below, the 3 gates are:
 			// (a => c), (a => b) and (a => d).
 			//   b | c
 			//   --+--
 			//   a | d
-			using Gates1Map = NestedNestedDefaultedUnorderedMap<QdNode*, int, int, Gate*, nullptr>;
-			Gates1Map gates1;
+			// and up to 8 gates from the cell of a 1x1 node, one for each neighbour cell.
+			struct GateCellGates
+			{
+				// number of gates starting from this cell.
+				int n = 0;
+				// position of this cell in its node's gateCellsOfNode list.
+				int pos = -1;
+				// id of the node this cell locates.
+				int node = -1;
+				Gate* gates[8];
+			};
+			// gatesOfCell[gate cell index] => gates starting from the gate cell.
+			std::vector<GateCellGates> gatesOfCell;
+			// gateCellsOfNode[node id] => [ gate cell index .. ], the gate cells inside the node.
+			std::vector<std::vector<int>> gateCellsOfNode;
+
+			// ~~~~~~~~~~~~~~ Snapshot ~~~~~~~~~~~~~
+			// frozen is true if the snapshot is up to date.
+			bool				frozen = false;
+			QuadtreeMapSnapshot snapshot;
+
+			// ~~~~~~~~~~~~~~ Landmarks ~~~~~~~~~~~~~
+			// number of landmarks on each graph, 0 for disabled.
+			int		  numLandmarks = 0;
+			Landmarks landmarks1, landmarks2;
+			// the node ids and gate cell indexes of which the edges are changed since the last repair,
+			// recorded only if the landmarks are enabled.
+			std::vector<int> touchedNodeIds, touchedGateCells;
+
+			bool LandmarksUpToDate() const
+			{
+				return numLandmarks > 0 && touchedNodeIds.empty() && touchedGateCells.empty();
+			}
+			void TouchNodeId(int id);
+			void TouchGateCell(int i);
+
+			// ~~~~~~~~~~~~~~ Contraction Hierarchy ~~~~~~~~~~~~~
+			// hierarchyUpToDate is true if the index is built (or given up, then hierarchyBuilt is false)
+			// and the map is not changed since.
+			bool				 hierarchyUpToDate = false, hierarchyBuilt = false;
+			ContractionHierarchy hierarchy;
+
+			// ~~~~~~~~~~~~~~ Node Distance Oracle ~~~~~~~~~~~~~
+			// the max size of the components with tables, 0 for disabled.
+			int			   oracleMaxSize = 0;
+			DistanceOracle oracle;
+			// the node ids touched since the last repair (see TouchNodeId), recorded only if the oracle
+			// is enabled.
+			std::vector<int> oracleTouchedNodeIds;
+
+			// ~~~~~~~~~~~~~~ Counters ~~~~~~~~~~~~~
+			// number of HandleNewNode and HandleRemovedNode calls.
+			std::size_t numNewNodesHandled = 0, numRemovedNodesHandled = 0;
 
 			// ~~~~~~~~~~~~~~~~ Internals ~~~~~~~~~~~~~~~
 			void ForEachGateInNode(QdNode* node, std::function<void(Gate*)>& visitor) const;
@@ -181,15 +478,77 @@ namespace QDPF
 			void HandleRemovedNode(QdNode* aNode);
 			void ConnectCellsInGateGraphs(int u, int v);
 			void ConnectGateCellsInNodeToNewGateCell(QdNode* aNode, int a);
-			void DisconnectCellInGateGraphs(int u);
+			void AddGateCell(QdNode* aNode, int a);
+			void RemoveGateCell(QdNode* aNode, int a);
+			Gate* FindGate(int a, int b) const;
 			void ConnectNodesOnNodeGraph(QdNode* aNode, QdNode* bNode);
-			void DisconnectNodeFromNodeGraph(QdNode* aNode);
+			void RemoveNodeFromNodeGraph(QdNode* aNode);
 			void CreateGate(QdNode* aNode, int a, QdNode* bNode, int b);
 			void GetNeighbourCellsDiagonal(int direction, QdNode* aNode, int& a, int& b) const;
 			void GetNeighbourCellsHV(int direction, QdNode* aNode, QdNode* bNode,
 				std::vector<std::pair<int, int>>& ncs) const;
 		};
 
+		//////////////////////////////////////////
+		/// Implementation for Templated Functions
+		//////////////////////////////////////////
+
+		template <typename Visitor>
+		void QuadtreeMap::ForEachNeighbourGateCells(int u, Visitor&& visitor) const
+		{
+			int i = g2.IndexOf(u);
+			if (i == -1)
+				return;
+			ForEachNeighbourGateCellIndexes(i, [this, &visitor](int j, int cost) { visitor(g2.VertexAt(j), cost); });
+		}
+
+		template <typename Visitor>
+		void QuadtreeMap::ForEachNeighbourGateCellIndexes(int i, Visitor&& visitor) const
+		{
+			if (frozen)
+			{
+				snapshot.GateGraph.ForEachNeighbourIndexes(i, visitor);
+				if (!implicitIntraNodeEdges)
+					return;
+				auto u = g2.VertexAt(i);
+				int	 id = snapshot.NodeOfGateCell[i];
+				for (int k = snapshot.GateCellOffsets[id]; k < snapshot.GateCellOffsets[id + 1]; ++k)
+				{
+					int j = snapshot.GateCells[k];
+					if (j != i)
+						visitor(j, Distance(u, g2.VertexAt(j)));
+				}
+				return;
+			}
+			g2.ForEachNeighbourIndexes(i, visitor);
+			if (!implicitIntraNodeEdges)
+				return;
+			auto u = g2.VertexAt(i);
+			for (auto j : gateCellsOfNode[gatesOfCell[i].node])
+			{
+				if (j != i)
+					visitor(j, Distance(u, g2.VertexAt(j)));
+			}
+		}
+
+		template <typename Visitor>
+		void QuadtreeMap::ForEachNeighbourNodes(QdNode* node, Visitor&& visitor) const
+		{
+			int id = NodeId(node);
+			if (id == -1)
+				return;
+			ForEachNeighbourNodeIds(id, [this, &visitor](int j, int cost) { visitor(g1.VertexAt(j), cost); });
+		}
+
+		template <typename Visitor>
+		void QuadtreeMap::ForEachNeighbourNodeIds(int id, Visitor&& visitor) const
+		{
+			if (frozen)
+				snapshot.NodeGraph.ForEachNeighbourIndexes(id, visitor);
+			else
+				g1.ForEachNeighbourIndexes(id, visitor);
+		}
+
 	} // namespace Internal
 } // namespace QDPF
 
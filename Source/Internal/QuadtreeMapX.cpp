@@ -5,23 +5,61 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <unordered_set>
 
 #include "Base.h"
 #include "QuadtreeMapX.h"
+#include "Trace.h"
 
 namespace QDPF
 {
 	namespace Internal
 	{
 
+		namespace
+		{
+			// BuildCostMeter measures the wall time and allocations between Start() and Stop().
+			class BuildCostMeter
+			{
+			public:
+				BuildCostMeter(AllocationCounter& allocationCounter)
+					: allocationCounter(allocationCounter) {}
+
+				void Start()
+				{
+					if (allocationCounter != nullptr)
+						allocationCounter(numAllocations, numBytes);
+					start = std::chrono::steady_clock::now();
+				}
+
+				void Stop(BuildCost& cost)
+				{
+					auto d = std::chrono::steady_clock::now() - start;
+					cost.Milliseconds = std::chrono::duration<double, std::milli>(d).count();
+					if (allocationCounter != nullptr)
+					{
+						std::size_t numAllocations1, numBytes1;
+						allocationCounter(numAllocations1, numBytes1);
+						cost.NumAllocations = numAllocations1 - numAllocations;
+						cost.AllocatedBytes = numBytes1 - numBytes;
+					}
+				}
+
+			private:
+				AllocationCounter&					  allocationCounter;
+				std::chrono::steady_clock::time_point start;
+				std::size_t							  numAllocations = 0, numBytes = 0;
+			};
+		} // namespace
+
 		QuadtreeMapXImpl::QuadtreeMapXImpl(int w, int h, DistanceCalculator distance,
 			TerrainTypesChecker	 terrainChecker,
 			QuadtreeMapXSettings settings, int step, StepFunction stepf,
 			int maxNodeWidth, int maxNodeHeight,
-			ClearanceFieldKind clearanceFieldKind)
-			: w(w), h(h), distance(distance), terrainChecker(terrainChecker), settings(settings), step(step), stepf(stepf), maxNodeWidth(maxNodeWidth), maxNodeHeight(maxNodeHeight), clearanceFieldKind(clearanceFieldKind)
+			ClearanceFieldKind clearanceFieldKind, bool implicitIntraNodeEdges)
+			: w(w), h(h), distance(distance), terrainChecker(terrainChecker), settings(settings), step(step), stepf(stepf), maxNodeWidth(maxNodeWidth), maxNodeHeight(maxNodeHeight), clearanceFieldKind(clearanceFieldKind), implicitIntraNodeEdges(implicitIntraNodeEdges)
 		{
 			assert(w > 0);
 			assert(h > 0);
@@ -47,6 +85,73 @@ namespace QDPF
 			dirties.clear();
 		}
 
+		void QuadtreeMapXImpl::Freeze()
+		{
+			frozen = true;
+			FreezeQuadtreeMaps();
+		}
+
+		void QuadtreeMapXImpl::BuildLandmarks(int k)
+		{
+			numLandmarks = std::max(k, 0);
+			BuildLandmarksOfQuadtreeMaps();
+		}
+
+		// Builds the landmarks of all quadtree maps, with numLandmarks landmarks on each graph.
+		void QuadtreeMapXImpl::BuildLandmarksOfQuadtreeMaps()
+		{
+			for (auto& [agentSize, d] : maps)
+			{
+				for (auto [terrainTypes, m] : d)
+					m->BuildLandmarks(numLandmarks);
+			}
+		}
+
+		void QuadtreeMapXImpl::BuildContractionHierarchy()
+		{
+			hierarchies = true;
+			BuildContractionHierarchiesOfQuadtreeMaps();
+		}
+
+		// Builds the contraction hierarchies of the quadtree maps, the ones up to date are skipped.
+		void QuadtreeMapXImpl::BuildContractionHierarchiesOfQuadtreeMaps()
+		{
+			for (auto& [agentSize, d] : maps)
+			{
+				for (auto [terrainTypes, m] : d)
+					m->BuildContractionHierarchy();
+			}
+		}
+
+		void QuadtreeMapXImpl::BuildNodeDistanceOracle(int maxSize)
+		{
+			oracleMaxSize = std::max(maxSize, 0);
+			BuildNodeDistanceOraclesOfQuadtreeMaps();
+		}
+
+		// Builds the node distance oracles of all quadtree maps, with oracleMaxSize.
+		void QuadtreeMapXImpl::BuildNodeDistanceOraclesOfQuadtreeMaps()
+		{
+			for (auto& [agentSize, d] : maps)
+			{
+				for (auto [terrainTypes, m] : d)
+					m->BuildNodeDistanceOracle(oracleMaxSize);
+			}
+		}
+
+		// Freezes the quadtree maps that are not frozen or changed since the last freeze.
+		void QuadtreeMapXImpl::FreezeQuadtreeMaps()
+		{
+			for (auto& [agentSize, d] : maps)
+			{
+				for (auto [terrainTypes, m] : d)
+				{
+					if (m->Snapshot() == nullptr)
+						m->Freeze();
+				}
+			}
+		}
+
 		// Query a QuadtreeMap by given agent size and walkable terrain types (capablities).
 		const QuadtreeMap* QuadtreeMapXImpl::Get(int agentSize, int walkableTerrainTypes) const
 		{
@@ -84,6 +189,8 @@ namespace QDPF
 
 		void QuadtreeMapXImpl::Update(int x, int y)
 		{
+			QDPF_TRACE_SCOPE("QuadtreeMapX::Update");
+
 			// Update the clearance values
 			for (auto [_, cf] : cfs)
 				cf->Update(x, y);
@@ -91,14 +198,18 @@ namespace QDPF
 
 		void QuadtreeMapXImpl::Compute()
 		{
+			QDPF_TRACE_SCOPE("QuadtreeMapX::Compute");
+
 			// Apply the clearance updates for each field.
 			for (auto [_, cf] : cfs)
 				cf->Compute();
 
 			// Update all cells in related quadtree maps.
 			// Of which the clearance value is recomputed, we should maintain the gate cells etc.
+			numDirtyCells = 0;
 			for (auto& [terrainTypes, vec] : dirties)
 			{
+				numDirtyCells += vec.size();
 				for (auto m : maps1[terrainTypes])
 				{
 					for (auto [x, y] : vec)
@@ -106,21 +217,120 @@ namespace QDPF
 				}
 			}
 
+			// Freeze the changed quadtree maps again.
+			if (frozen)
+				FreezeQuadtreeMaps();
+
+			// Repair the landmarks of the changed quadtree maps.
+			if (numLandmarks > 0)
+			{
+				for (auto& [terrainTypes, vec] : dirties)
+				{
+					for (auto m : maps1[terrainTypes])
+						m->RepairLandmarks();
+				}
+			}
+
+			// Repair the node distance oracles of the changed quadtree maps, the tables of the changed
+			// components are computed again.
+			if (oracleMaxSize > 0)
+			{
+				for (auto& [terrainTypes, vec] : dirties)
+				{
+					for (auto m : maps1[terrainTypes])
+						m->RepairNodeDistanceOracle();
+				}
+			}
+
 			dirties.clear();
 		}
 
-		void QuadtreeMapXImpl::Build()
+		std::size_t QuadtreeMapXStats::TotalBytes() const
 		{
+			std::size_t n = Dirties.Bytes;
+			for (auto& r : QuadtreeMaps)
+				n += r.Stats.TotalBytes();
+			for (auto& r : ClearanceFields)
+				n += r.Memory.Bytes;
+			return n;
+		}
+
+		QuadtreeMapXStats QuadtreeMapXImpl::Stats() const
+		{
+			QuadtreeMapXStats stats;
+			stats.GridBytes = static_cast<std::size_t>(w) * h * sizeof(int);
+
+			for (auto& [agentSize, d] : maps)
+			{
+				for (auto [terrainTypes, m] : d)
+					stats.QuadtreeMaps.push_back({ agentSize, terrainTypes, m->Stats() });
+			}
+
+			for (auto [terrainTypes, cf] : cfs)
+			{
+				std::size_t numCells = static_cast<std::size_t>(w) * h;
+				stats.ClearanceFields.push_back({ terrainTypes, { numCells, numCells * sizeof(int) } });
+			}
+
+			stats.Dirties.Bytes = EstimateMemoryBytes(dirties);
+			for (auto& [_, vec] : dirties)
+			{
+				stats.Dirties.NumEntries += vec.size();
+				stats.Dirties.Bytes += EstimateMemoryBytes(vec);
+			}
+			return stats;
+		}
+
+		void QuadtreeMapXImpl::Build(BuildReport* report, AllocationCounter allocationCounter)
+		{
+			QDPF_TRACE_SCOPE("QuadtreeMapX::Build");
+
+			BuildCostMeter total(allocationCounter), meter(allocationCounter);
+
+			// Runs a phase, and records its cost if the report is provided.
+			auto phase = [report, &meter](const char* name, const std::function<void()>& fn) {
+				if (report == nullptr)
+					return fn();
+				report->Phases.push_back({ name });
+				meter.Start();
+				fn();
+				meter.Stop(report->Phases.back().Cost);
+			};
+
+			if (report != nullptr)
+			{
+				// avoid counting the allocations of the report itself as possible.
+				report->Phases.reserve(report->Phases.size() + 9);
+				report->ClearanceFields.reserve(report->ClearanceFields.size() + settings.size());
+				report->QuadtreeMaps.reserve(report->QuadtreeMaps.size() + settings.size());
+				total.Start();
+			}
+
 			// Creates a quadtree map for each pair of {agentSize, terrainTypes}.
-			CreateQuadtreeMaps();
+			phase("CreateQuadtreeMaps", [this] { CreateQuadtreeMaps(); });
 			// Creates a clearance field for each terrainTypes.
-			CreateClearanceFields();
+			phase("CreateClearanceFields", [this] { CreateClearanceFields(); });
 			// Initial the clearance fields.
-			BuildClearanceFields();
+			phase("BuildClearanceFields", [&] { BuildClearanceFields(report, allocationCounter); });
 			// Build the quadtree maps on existing terrains.
-			BuildQuadtreeMaps();
+			phase("BuildQuadtreeMaps", [&] { BuildQuadtreeMaps(report, allocationCounter); });
 			// Bind them via a queue.
-			BindClearanceFieldAndQuadtreeMaps();
+			phase("BindClearanceFieldAndQuadtreeMaps", [this] { BindClearanceFieldAndQuadtreeMaps(); });
+			// Freeze the quadtree maps if Freeze() is called before.
+			if (frozen)
+				phase("FreezeQuadtreeMaps", [this] { FreezeQuadtreeMaps(); });
+			// Build the landmarks if BuildLandmarks() is called before.
+			if (numLandmarks > 0)
+				phase("BuildLandmarks", [this] { BuildLandmarksOfQuadtreeMaps(); });
+			// Build the contraction hierarchies if BuildContractionHierarchy() is called before.
+			if (hierarchies)
+				phase("BuildContractionHierarchies", [this] { BuildContractionHierarchiesOfQuadtreeMaps(); });
+			// Build the node distance oracles if BuildNodeDistanceOracle() is called before.
+			if (oracleMaxSize > 0)
+				phase("BuildNodeDistanceOracles", [this] { BuildNodeDistanceOraclesOfQuadtreeMaps(); });
+
+			if (report != nullptr)
+				total.Stop(report->Total);
 		}
 
 		// Creates a clearance field for each terrainTypes integer.
@@ -194,10 +404,19 @@ namespace QDPF
 		}
 
 		// Build each of clearance field.
-		void QuadtreeMapXImpl::BuildClearanceFields()
+		// Records the cost of each clearance field if the report is provided.
+		void QuadtreeMapXImpl::BuildClearanceFields(BuildReport* report, AllocationCounter& allocationCounter)
 		{
-			for (auto [_, cf] : cfs)
+			BuildCostMeter meter(allocationCounter);
+
+			for (auto [terrainTypes, cf] : cfs)
 			{
+				if (report != nullptr)
+				{
+					report->ClearanceFields.push_back({ terrainTypes });
+					meter.Start();
+				}
+
 				// here: just build on an **empty** map.
 				cf->Build();
 
@@ -210,6 +429,9 @@ namespace QDPF
 
 				// Finally, call Compute for the initial clearance field.
 				cf->Compute();
+
+				if (report != nullptr)
+					meter.Stop(report->ClearanceFields.back().Cost);
 			}
 		}
 
@@ -232,7 +454,8 @@ namespace QDPF
 					return true;
 				return false;
 			};
-			auto m = new QuadtreeMap(w, h, isObstacle, distance, step, stepf, maxNodeWidth, maxNodeHeight);
+			auto m = new QuadtreeMap(w, h, isObstacle, distance, step, stepf, maxNodeWidth, maxNodeHeight,
+				implicitIntraNodeEdges);
 
 			maps[agentSize][terrainTypes] = m;
 			maps1[terrainTypes].push_back(m);
@@ -240,12 +463,33 @@ namespace QDPF
 
 		// Build each quadtree map with existing obstacles (different for different terrains).
 		// This should be most slow step of the whole Build().
-		void QuadtreeMapXImpl::BuildQuadtreeMaps()
+		// Records the cost and object counts of each map if the report is provided.
+		void QuadtreeMapXImpl::BuildQuadtreeMaps(BuildReport* report, AllocationCounter& allocationCounter)
 		{
-			for (auto [_, d] : maps)
+			BuildCostMeter meter(allocationCounter);
+
+			for (auto [agentSize, d] : maps)
 			{
-				for (auto [_, m] : d)
+				for (auto [terrainTypes, m] : d)
+				{
+					if (report == nullptr)
+					{
+						m->Build();
+						continue;
+					}
+
+					report->QuadtreeMaps.push_back({ agentSize, terrainTypes });
+					auto& r = report->QuadtreeMaps.back();
+
+					meter.Start();
 					m->Build();
+					meter.Stop(r.Cost);
+
+					r.NumNodes = m->NumLeafNodes();
+					r.NumGates = m->NumGates();
+					r.NumGateGraphEdges = m->GetGateGraph().NumEdges();
+					r.NumNodeGraphEdges = m->GetNodeGraph().NumEdges();
+				}
 			}
 		}
 
@@ -9,7 +9,9 @@
 // A manager of multiple quadtree maps to support different agent sizes and terrain types.
 
 #include <initializer_list>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "ClearanceField/Source/ClearanceField.h"
 #include "QuadtreeMap.h"
@@ -39,20 +41,105 @@ namespace QDPF
 		// TerrainTypesChecker is to check the terrain type value for given cell (x,y)
 		using TerrainTypesChecker = std::function<int(int x, int y)>;
 
+		// ~~~~~~~~~~~~~~ Build Report ~~~~~~~~~~~~~
+
+		// AllocationCounter reads the current number of allocations and allocated bytes (accumulated).
+		// It's provided by the user, e.g. backed by a replaced global operator new.
+		using AllocationCounter = std::function<void(std::size_t& numAllocations, std::size_t& numBytes)>;
+
+		// BuildCost is the cost of a step during the build.
+		struct BuildCost
+		{
+			double Milliseconds = 0;
+			// Deltas of the allocation counter, always 0 if no allocation counter is provided.
+			std::size_t NumAllocations = 0, AllocatedBytes = 0;
+		};
+
+		// Report of a build phase, e.g. "BuildQuadtreeMaps".
+		struct BuildPhaseReport
+		{
+			std::string Name;
+			BuildCost	Cost;
+		};
+
+		// Report of building the clearance field for a terrain types.
+		struct BuildClearanceFieldReport
+		{
+			int		  TerrainTypes;
+			BuildCost Cost;
+		};
+
+		// Report of building the quadtree map for a setting, along with the resulting object counts.
+		struct BuildQuadtreeMapReport
+		{
+			int		  AgentSize, TerrainTypes;
+			BuildCost Cost;
+			// number of leaf nodes.
+			std::size_t NumNodes = 0;
+			// number of gates, dual gates are counted twice.
+			std::size_t NumGates = 0;
+			// number of directed edges on the gate graph and the node graph.
+			std::size_t NumGateGraphEdges = 0, NumNodeGraphEdges = 0;
+		};
+
+		// BuildReport records the cost of each phase of QuadtreeMapXImpl::Build(), and the cost of each
+		// clearance field and quadtree map.
+		struct BuildReport
+		{
+			BuildCost							   Total;
+			std::vector<BuildPhaseReport>		   Phases;
+			std::vector<BuildClearanceFieldReport> ClearanceFields;
+			std::vector<BuildQuadtreeMapReport>	   QuadtreeMaps;
+		};
+
+		// ~~~~~~~~~~~~~~ Stats ~~~~~~~~~~~~~
+
+		// Statistics of the quadtree map for a setting.
+		struct QuadtreeMapXMapStats
+		{
+			int				 AgentSize, TerrainTypes;
+			QuadtreeMapStats Stats;
+		};
+
+		// Memory usage of the clearance field for a terrain types.
+		// It's estimated by the clearance values grid (w*h integers), entries are cells.
+		struct ClearanceFieldStats
+		{
+			int			TerrainTypes;
+			MemoryUsage Memory;
+		};
+
+		// QuadtreeMapXStats aggregates the statistics of all quadtree maps and clearance fields.
+		struct QuadtreeMapXStats
+		{
+			std::vector<QuadtreeMapXMapStats> QuadtreeMaps;
+			std::vector<ClearanceFieldStats>  ClearanceFields;
+			// the dirty queues bridging clearance fields and quadtree maps, entries are queued cells.
+			MemoryUsage Dirties;
+			// bytes of the grid itself for reference: w*h terrain values (as int).
+			std::size_t GridBytes = 0;
+
+			// Returns the sum of bytes of all quadtree maps, clearance fields and dirty queues.
+			std::size_t TotalBytes() const;
+		};
+
 		class QuadtreeMapXImpl
 		{
 		public:
 			QuadtreeMapXImpl(int w, int h, DistanceCalculator distance, TerrainTypesChecker terrainChecker,
 				QuadtreeMapXSettings settings, int step = 1, StepFunction stepf = nullptr,
 				int maxNodeWidth = -1, int maxNodeHeight = -1,
-				ClearanceFieldKind clearanceFieldKind = ClearanceFieldKind::TrueClearanceField);
+				ClearanceFieldKind clearanceFieldKind = ClearanceFieldKind::TrueClearanceField,
+				bool implicitIntraNodeEdges = false);
 			~QuadtreeMapXImpl();
 
 			int W() const { return w; }
 			int H() const { return h; }
 
 			// Creates quadtree maps, clearance fields and call Update on existing grid map for each cell.
-			void Build();
+			// If report is provided, the cost of each phase is recorded into it. The optional
+			// allocationCounter is used to record the allocations.
+			void Build(BuildReport* report = nullptr, AllocationCounter allocationCounter = nullptr);
 
 			// Find a quadtree map by agent size and walkable terrain types.
 			// Returns nullptr on not found.
@@ -66,6 +153,35 @@ namespace QDPF
 			// quadtree maps.
 			void Compute();
 
+			// Freezes all quadtree maps (see QuadtreeMap::Freeze), and keeps them frozen: the changed maps
+			// are frozen again at the end of each Compute() (and Build()).
+			void Freeze();
+
+			// Builds k landmarks on the graphs of all quadtree maps (see QuadtreeMap::BuildLandmarks), and
+			// keeps them: the landmarks of the changed maps are repaired at the end of each Compute() (and
+			// built in Build()). k = 0 drops the landmarks.
+			void BuildLandmarks(int k);
+
+			// Builds the contraction hierarchies of all quadtree maps (see
+			// QuadtreeMap::BuildContractionHierarchy), skipping the ones up to date. They are built in
+			// Build() as well if this is called before. Compute() doesn't rebuild them, the changed maps
+			// fall back to the searches on the graphs, until this is called again.
+			void BuildContractionHierarchy();
+
+			// Builds the node distance oracles of all quadtree maps (see
+			// QuadtreeMap::BuildNodeDistanceOracle), for the components of at most maxSize nodes, and
+			// keeps them: the oracles of the changed maps are repaired at the end of each Compute(), which
+			// computes the tables of the changed components again. They are built in Build() as well if
+			// this is called before. maxSize = 0 drops the oracles.
+			void BuildNodeDistanceOracle(int maxSize);
+
+			// Returns the number of dirty cells applied by the last Compute() call, summed over all
+			// terrain types.
+			std::size_t NumDirtyCells() const { return numDirtyCells; }
+
+			// Collects the statistics of all managed quadtree maps and clearance fields.
+			QuadtreeMapXStats Stats() const;
+
 		private:
 			const int				   w, h, maxNodeWidth, maxNodeHeight;
 			const int				   step;
@@ -74,6 +190,7 @@ namespace QDPF
 			TerrainTypesChecker		   terrainChecker;
 			const QuadtreeMapXSettings settings;
 			const ClearanceFieldKind   clearanceFieldKind;
+			const bool				   implicitIntraNodeEdges;
 
 			// ~~~~~~~ clearance fields ~~~~~~~~~~~
 			// cfs[terrainTypes] => cf.
@@ -89,17 +206,35 @@ namespace QDPF
 			// they are cleared after Compute().
 			// dirties[terrainTypes] => {(x,y), ...}
 			std::unordered_map<int, std::vector<std::pair<int, int>>> dirties;
+			// number of dirty cells applied by the last Compute().
+			std::size_t numDirtyCells = 0;
+
+			// is Freeze() called? keeps the quadtree maps frozen.
+			bool frozen = false;
+			void FreezeQuadtreeMaps();
+
+			// number of landmarks on each graph of each quadtree map, 0 for disabled.
+			int	 numLandmarks = 0;
+			void BuildLandmarksOfQuadtreeMaps();
+
+			// is BuildContractionHierarchy() called? builds them in Build().
+			bool hierarchies = false;
+			void BuildContractionHierarchiesOfQuadtreeMaps();
+
+			// max size of the components with node distance tables of each quadtree map, 0 for disabled.
+			int	 oracleMaxSize = 0;
+			void BuildNodeDistanceOraclesOfQuadtreeMaps();
 
 			// ~~~~~ clearance fields ~~~~~~~
 			void CreateClearanceFields();
 			void CreateClearanceFieldForTerrainTypes(int agentSizeBound, int costUnit, int costUnitDiagonal,
 				int terrainTypes);
-			void BuildClearanceFields();
+			void BuildClearanceFields(BuildReport* report, AllocationCounter& allocationCounter);
 
 			// ~~~~~ quadtree maps ~~~~~~~
 			void CreateQuadtreeMaps();
 			void CreateQuadtreeMapsForSetting(int agentSize, int terrainTypes);
-			void BuildQuadtreeMaps();
+			void BuildQuadtreeMaps(BuildReport* report, AllocationCounter& allocationCounter);
 
 			// ~~~~~ bind them ~~~~~~~
 			void BindClearanceFieldAndQuadtreeMaps();
@@ -0,0 +1,59 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#include "Trace.h"
+
+#ifdef QDPF_ENABLE_TRACING
+	#include <cstdio>
+	#include <thread>
+#endif
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+#ifdef QDPF_ENABLE_TRACING
+
+		static TraceSink traceSink = nullptr;
+
+		void SetTraceSink(TraceSink sink)
+		{
+			traceSink = sink;
+		}
+
+		// Microseconds since the epoch of the steady clock.
+		static double ToUs(std::chrono::steady_clock::time_point t)
+		{
+			return std::chrono::duration<double, std::micro>(t.time_since_epoch()).count();
+		}
+
+		ScopedTrace::ScopedTrace(const char* name)
+			: name(name), enabled(traceSink != nullptr)
+		{
+			if (enabled)
+				start = std::chrono::steady_clock::now();
+		}
+
+		ScopedTrace::~ScopedTrace()
+		{
+			if (!enabled || traceSink == nullptr)
+				return;
+			auto end = std::chrono::steady_clock::now();
+			auto tid = static_cast<unsigned int>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+			char event[256];
+			std::snprintf(event, sizeof event,
+				"{\"name\":\"%s\",\"cat\":\"qdpf\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				name, ToUs(start), ToUs(end) - ToUs(start), tid);
+			traceSink(event);
+		}
+
+#else
+
+		void SetTraceSink(TraceSink sink) {}
+
+#endif
+
+	} // namespace Internal
+} // namespace QDPF
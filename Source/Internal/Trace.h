@@ -0,0 +1,63 @@
+// Source Code: https://github.com/hit9/quadtree-pathfinding
+// License: BSD. Chao Wang, hit9[At]icloud.com.
+
+#ifndef QDPF_INTERNAL_TRACE_HPP
+#define QDPF_INTERNAL_TRACE_HPP
+
+#include <functional> // for std::function
+
+#ifdef QDPF_ENABLE_TRACING
+	#include <chrono> // for std::chrono
+#endif
+
+// Trace
+// ~~~~~
+// Scoped trace markers, emitted as Chrome trace events (the JSON format Perfetto also reads).
+// They are compiled in only if QDPF_ENABLE_TRACING is defined (the cmake option of the same name),
+// otherwise the QDPF_TRACE_SCOPE macro expands to nothing.
+
+namespace QDPF
+{
+	namespace Internal
+	{
+
+		// TraceSink receives each trace event as a complete JSON object, e.g.
+		// {"name":"QuadtreeMapX::Compute","cat":"qdpf","ph":"X","ts":12.000,"dur":3.500,"pid":1,"tid":1}
+		// It's called on the thread which runs the traced call.
+		using TraceSink = std::function<void(const char* event)>;
+
+		// Sets the global trace sink, nullptr to stop tracing.
+		// Does nothing if the library is compiled without QDPF_ENABLE_TRACING.
+		void SetTraceSink(TraceSink sink);
+
+#ifdef QDPF_ENABLE_TRACING
+
+		// ScopedTrace emits a complete event ("ph":"X") for the lifetime of itself.
+		// The timestamps are microseconds of std::chrono::steady_clock since its epoch.
+		class ScopedTrace
+		{
+		public:
+			explicit ScopedTrace(const char* name);
+			~ScopedTrace();
+
+		private:
+			const char*							  name;
+			bool								  enabled;
+			std::chrono::steady_clock::time_point start;
+		};
+
+	#define QDPF_TRACE_CONCAT_(a, b) a##b
+	#define QDPF_TRACE_CONCAT(a, b) QDPF_TRACE_CONCAT_(a, b)
+	#define QDPF_TRACE_SCOPE(name) \
+		::QDPF::Internal::ScopedTrace QDPF_TRACE_CONCAT(qdpfTraceScope, __LINE__)(name)
+
+#else
+
+	#define QDPF_TRACE_SCOPE(name)
+
+#endif
+
+	} // namespace Internal
+} // namespace QDPF
+
+#endif
@@ -13,14 +13,18 @@ namespace QDPF
 	QuadtreeMapX::QuadtreeMapX(int w, int h, DistanceCalculator distance,
 		TerrainTypesChecker terrainChecker, QuadtreeMapXSettings settings,
 		int step, StepFunction stepf, int maxNodeWidth, int maxNodeHeight,
-		ClearanceFieldKind clearanceFieldKind)
+		ClearanceFieldKind clearanceFieldKind, bool implicitIntraNodeEdges)
 		: impl(Internal::QuadtreeMapXImpl(w, h, distance, terrainChecker, settings, step, stepf,
-			  maxNodeWidth, maxNodeHeight, clearanceFieldKind)) {}
+			  maxNodeWidth, maxNodeHeight, clearanceFieldKind, implicitIntraNodeEdges)) {}
 
 	void QuadtreeMapX::Build()
 	{
 		impl.Build();
 	}
+	void QuadtreeMapX::Build(BuildReport& report, AllocationCounter allocationCounter)
+	{
+		impl.Build(&report, allocationCounter);
+	}
 	void QuadtreeMapX::Update(int x, int y)
 	{
 		impl.Update(x, y);
@@ -29,6 +33,30 @@ namespace QDPF
 	{
 		impl.Compute();
 	}
+
+	void QuadtreeMapX::Freeze()
+	{
+		impl.Freeze();
+	}
+
+	void QuadtreeMapX::BuildLandmarks(int k)
+	{
+		impl.BuildLandmarks(k);
+	}
+
+	void QuadtreeMapX::BuildContractionHierarchy()
+	{
+		impl.BuildContractionHierarchy();
+	}
+
+	void QuadtreeMapX::BuildNodeDistanceOracle(int maxSize)
+	{
+		impl.BuildNodeDistanceOracle(maxSize);
+	}
+	QuadtreeMapXStats QuadtreeMapX::Stats() const
+	{
+		return impl.Stats();
+	}
 	const Internal::QuadtreeMap* QuadtreeMapX::Get(int agentSize, int terrainTypes) const
 	{
 		return impl.Get(agentSize, terrainTypes);
@@ -41,12 +69,13 @@ namespace QDPF
 	AStarPathFinder::AStarPathFinder(const QuadtreeMapX& mx)
 		: mx(mx) {}
 
-	int AStarPathFinder::Reset(int x1, int y1, int x2, int y2, int agentSize, int terrainTypes)
+	int AStarPathFinder::Reset(int x1, int y1, int x2, int y2, int agentSize, int terrainTypes,
+		PathfinderStats* stats)
 	{
 		auto m = mx.Get(agentSize, terrainTypes);
 		if (m == nullptr)
 			return -1;
-		impl.Reset(m, x1, y1, x2, y2);
+		impl.Reset(m, x1, y1, x2, y2, stats);
 		return 0;
 	}
 
@@ -55,6 +84,11 @@ namespace QDPF
 		return impl.ComputeNodeRoutes(nodePath);
 	}
 
+	int AStarPathFinder::ComputeNodeDistance(int x, int y)
+	{
+		return impl.ComputeNodeDistance(x, y);
+	}
+
 	int AStarPathFinder::ComputeGateRoutes(GateRouteCollector& collector, const NodePath& nodePath)
 	{
 		return impl.ComputeGateRoutes(collector, nodePath);
@@ -77,6 +111,11 @@ namespace QDPF
 		return ComputeGateRoutes(collector);
 	}
 
+	void AStarPathFinder::SetBidirectional(bool bidirectional)
+	{
+		impl.SetBidirectional(bidirectional);
+	}
+
 	//////////////////////////////////////
 	/// FlowFieldPathFinder
 	//////////////////////////////////////
@@ -85,12 +124,12 @@ namespace QDPF
 		: mx(mx) {}
 
 	int FlowFieldPathFinder::Reset(int x2, int y2, const Rectangle& dest, int agentSize,
-		int walkableterrainTypes)
+		int walkableterrainTypes, PathfinderStats* stats)
 	{
 		auto m = mx.Get(agentSize, walkableterrainTypes);
 		if (m == nullptr)
 			return -1;
-		impl.Reset(m, x2, y2, dest);
+		impl.Reset(m, x2, y2, dest, stats);
 		return 0;
 	}
 
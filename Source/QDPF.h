@@ -4,6 +4,21 @@
 // Quadtree reference: https://github.com/hit9/quadtree-hpp
 
 // Changes:
+// 2026/10/16 v0.5.18: Fix FlowFieldPathFinder leaving the gate cells of the target's node unreachable,
+//                     when the gate flow field is computed on a node flow field.
+// 2026/10/16 v0.5.17: Flow fields use a radix heap queue, the ties may resolve differently. A* uses
+//                     the indexed heap again, v0.5.13 ~ v0.5.16 differ by a cost unit on a few routes.
+// 2026/10/16 v0.5.16: Add MapX.BuildNodeDistanceOracle() and AStarPathFinder.ComputeNodeDistance().
+// 2026/10/16 v0.5.15: Add MapX.BuildContractionHierarchy() for fast gate routes on static maps.
+// 2026/10/16 v0.5.14: Add MapX.BuildLandmarks() and QuadtreeMap.BuildLandmarks() for ALT heuristics.
+// 2026/10/16 v0.5.13: Add AStarPathFinder.SetBidirectional() for bidirectional gate searches.
+// 2026/10/16 v0.5.12: Add MapX.Freeze() and QuadtreeMap.Freeze() for read-optimized snapshots.
+// 2026/10/16 v0.5.11: Add option implicitIntraNodeEdges to QuadtreeMapX.
+// 2026/10/16 v0.5.10: Add trace-event instrumentation behind the cmake option QDPF_ENABLE_TRACING.
+// 2026/10/16 v0.5.9: Add MapX.Stats() and QuadtreeMap.Stats() for memory and topology statistics.
+// 2026/10/16 v0.5.8: Add optional PathfinderStats to path finders' Reset().
+// 2026/10/16 v0.5.7: Add optional build report to MapX.Build().
+// 2026/10/16 v0.5.6: Add MapX.NumDirtyCells() and node changes counters on QuadtreeMap.
 // 2024/09/29 v0.5.5: Upgrade deps Quadtree-hpp to v0.4.1
 // 2024/09/27 v0.5.4: Improve the cmake 3rdParty deps management
 // 2024/09/27 v0.5.3: Update 3rdParty/ClearanceField
@@ -60,6 +75,7 @@
 #include "Internal/PathfinderFlowfield.h"
 #include "Internal/QuadtreeMap.h"
 #include "Internal/QuadtreeMapX.h"
+#include "Internal/Trace.h"
 
 namespace QDPF
 {
@@ -85,6 +101,32 @@ namespace QDPF
 	// Signature: void ComputeStraightLine(int x1, int y1, int x2, int y2, CellCollector &collector);
 	using Internal::ComputeStraightLine;
 
+	//////////////////////////////////////
+	/// Tracing
+	//////////////////////////////////////
+
+	// TraceSink is the type of a function to receive trace events.
+	// Each event is a complete JSON object in the Chrome trace event format, which Perfetto and
+	// chrome://tracing can load, after joining the events into a JSON array:
+	//
+	//   {"name":"QuadtreeMapX::Compute","cat":"qdpf","ph":"X","ts":12.000,"dur":3.500,"pid":1,"tid":1}
+	//
+	// The ts and dur are in microseconds, ts is based on the epoch of std::chrono::steady_clock.
+	// The sink is called on the thread which runs the traced call.
+	//
+	// Signature: std::function<void(const char* event)>;
+	using TraceSink = Internal::TraceSink;
+
+	// SetTraceSink sets the global trace sink, pass nullptr to stop tracing.
+	// Traced calls: QuadtreeMapX's Build, Update and Compute, QuadtreeMap's HandleNewNode and
+	// HandleRemovedNode, path finders' Reset and each Compute stage, and the search algorithms.
+	//
+	// The markers are compiled in only with the cmake option QDPF_ENABLE_TRACING=ON, otherwise they
+	// cost nothing and this function does nothing.
+	//
+	// Signature: void SetTraceSink(TraceSink sink);
+	using Internal::SetTraceSink;
+
 	//////////////////////////////////////
 	/// QuadtreeMapX
 	//////////////////////////////////////
@@ -176,6 +218,73 @@ namespace QDPF
 	// for more details, go ahead at: https://github.com/hit9/clearance-field
 	using Internal::ClearanceFieldKind;
 
+	// AllocationCounter is the type of a function to read the current number of allocations and
+	// allocated bytes (accumulated) of the process. It's provided by the user, e.g. backed by a
+	// replaced global operator new. The library doesn't count allocations itself.
+	//
+	// Signature: std::function<void(std::size_t& numAllocations, std::size_t& numBytes)>;
+	using AllocationCounter = Internal::AllocationCounter;
+
+	// BuildReport records the cost of QuadtreeMapX's Build(), phase by phase.
+	//
+	// struct BuildCost {
+	//   double Milliseconds;
+	//   std::size_t NumAllocations, AllocatedBytes; // 0 if no allocation counter is provided.
+	// };
+	//
+	// struct BuildReport {
+	//   // cost of the whole build.
+	//   BuildCost Total;
+	//   // cost of each phase, in order: CreateQuadtreeMaps, CreateClearanceFields,
+	//   // BuildClearanceFields, BuildQuadtreeMaps, BindClearanceFieldAndQuadtreeMaps.
+	//   std::vector<{ std::string Name; BuildCost Cost; }> Phases;
+	//   // cost of building the clearance field for each terrain types.
+	//   std::vector<{ int TerrainTypes; BuildCost Cost; }> ClearanceFields;
+	//   // cost of building the quadtree map for each setting, and the resulting object counts.
+	//   std::vector<{ int AgentSize, TerrainTypes; BuildCost Cost;
+	//                 std::size_t NumNodes, NumGates, NumGateGraphEdges, NumNodeGraphEdges; }>
+	//       QuadtreeMaps;
+	// };
+	using Internal::BuildCost;
+	using Internal::BuildReport;
+
+	// QuadtreeMapXStats is the memory usage and topology statistics of QuadtreeMapX.
+	// Bytes are estimated heap bytes, the allocator's overhead is not included.
+	//
+	// struct MemoryUsage { std::size_t NumEntries, Bytes; };
+	//
+	// struct Histogram {
+	//   // Buckets[0] counts the value 0, Buckets[k] counts values in [2^(k-1), 2^k).
+	//   std::vector<std::size_t> Buckets;
+	//   std::size_t NumSamples, Sum, Max;
+	//   double Mean() const;
+	// };
+	//
+	// struct QuadtreeMapStats {
+	//   // memory of each part of a quadtree map.
+	//   MemoryUsage Tree, NodeGraph, GateGraph, Gates, Gates1;
+	//   MemoryUsage Snapshot;      // see Freeze(), empty if not frozen.
+	//   MemoryUsage Landmarks;     // see BuildLandmarks(), empty if not built.
+	//   MemoryUsage Hierarchy;     // see BuildContractionHierarchy(), empty if not built.
+	//   MemoryUsage NodeDistances; // see BuildNodeDistanceOracle(), empty if not built.
+	//   std::size_t TotalBytes() const;
+	//   // topology.
+	//   std::size_t NumLeafNodes, NumObstacleLeafNodes;
+	//   Histogram GatesPerNode, OutDegreePerGateCell;
+	// };
+	//
+	// struct QuadtreeMapXStats {
+	//   std::vector<{ int AgentSize, TerrainTypes; QuadtreeMapStats Stats; }> QuadtreeMaps;
+	//   std::vector<{ int TerrainTypes; MemoryUsage Memory; }> ClearanceFields;
+	//   MemoryUsage Dirties;   // the dirty cells queued for the next Compute().
+	//   std::size_t GridBytes; // w*h terrain values, for reference.
+	//   std::size_t TotalBytes() const;
+	// };
+	using Internal::Histogram;
+	using Internal::MemoryUsage;
+	using Internal::QuadtreeMapStats;
+	using Internal::QuadtreeMapXStats;
+
 	// QuadtreeMapX is a manager of multiple 2D grid maps maintained by quadtrees.
 	class QuadtreeMapX
 	{
@@ -195,10 +304,15 @@ namespace QDPF
 		// * maxNodeWidth and maxNodeHeight the max width and height of a quadtree node's rectangle
 		// * clearanceFieldKind is the kind of the clearance-field implementer to use.
 		//   Ref: https://github.com/hit9/clearance-field
+		// * implicitIntraNodeEdges: if true, the edges between gate cells inside the same node are not
+		//   stored, but generated on the fly during the searches. Only the edges crossing nodes are
+		//   stored. This saves lots of memory and update time on maps with large empty nodes and small
+		//   steps, at the cost of computing the distances during the searches.
 		QuadtreeMapX(int w, int h, DistanceCalculator distance, TerrainTypesChecker terrainChecker,
 			QuadtreeMapXSettings settings, int step = 1, StepFunction stepf = nullptr,
 			int maxNodeWidth = -1, int maxNodeHeight = -1,
-			ClearanceFieldKind clearanceFieldKind = ClearanceFieldKind::TrueClearanceField);
+			ClearanceFieldKind clearanceFieldKind = ClearanceFieldKind::TrueClearanceField,
+			bool implicitIntraNodeEdges = false);
 
 		// Returns the w and h of the map.
 		int W() const { return impl.W(); }
@@ -209,6 +323,11 @@ namespace QDPF
 		// This method should be called before using any features of QuadtreeMapX.
 		void Build();
 
+		// Build with a report, to find out which phase is slow.
+		// The cost of each phase, each clearance field and each quadtree map is recorded into report.
+		// The optional allocationCounter is used to record allocations of each step.
+		void Build(BuildReport& report, AllocationCounter allocationCounter = nullptr);
+
 		// Update should be called if cell (x,y)'s terrain value is changed.
 		// Then Compute should be called to apply these changes.
 		void Update(int x, int y);
@@ -217,6 +336,50 @@ namespace QDPF
 		// It will apply all chanegs to all related quadtree maps.
 		void Compute();
 
+		// Freeze builds a read-optimized snapshot (flat arrays of the graphs and gates) for each
+		// quadtree map, the path finders search on the snapshots instead of the mutable graphs.
+		// The maps are kept frozen after calling this: the changed maps are frozen again at the end of
+		// each Compute(). It's worth for frames with many queries but few terrain changes.
+		void Freeze();
+
+		// BuildLandmarks picks k landmarks on the node graph and the gate graph of each quadtree map, and
+		// stores the exact distances from them. The A* path finders then use the triangle inequality
+		// bound as the heuristic, which saves many expansions on maps with walls and dead ends, at the
+		// memory of 2 * k ints per node and per gate cell. The landmarks are repaired at the end of each
+		// Compute(). k = 0 drops them. A k of 4~16 is recommended.
+		void BuildLandmarks(int k);
+
+		// BuildContractionHierarchy builds a contraction hierarchy index on the gate graph of each
+		// quadtree map. AStarPathFinder.ComputeGateRoutes (without a node path) then runs two small
+		// upward searches on it instead of the A*, which makes the queries on mazes and rooms many
+		// times faster. It gives up on the maps without bottlenecks (e.g. open fields), where the A* is
+		// fast already, so do the queries on them.
+		// It's for static maps: the build takes much longer than a query, and Compute() drops the
+		// index of the changed maps (the queries on them fall back to the A*). Call this again to
+		// rebuild the dropped ones, the unchanged maps are skipped. Calling it before Build() builds
+		// them in Build().
+		void BuildContractionHierarchy();
+
+		// BuildNodeDistanceOracle computes the distances and next hops between all pairs of nodes on
+		// the node graph of each quadtree map, for each connected component of at most maxSize nodes.
+		// AStarPathFinder.ComputeNodeRoutes and ComputeNodeDistance then walk on the tables or look
+		// them up instead of searching, and ComputeGateRoutes fails fast on unreachable targets. The
+		// memory is 2 * c * c ints for a component of c nodes, and the build runs a search from each
+		// node, so it's for small and medium maps: a maxSize of a few thousand is recommended.
+		// Compute() computes the tables of the changed components again, the unchanged ones are kept,
+		// so a changed component of c nodes costs c searches in Compute(): keep maxSize small on maps
+		// changing often. Calling it before Build() builds them in Build(). maxSize = 0 drops them.
+		void BuildNodeDistanceOracle(int maxSize);
+
+		// Returns the number of dirty cells applied by the last Compute() call, summed over all
+		// terrain types. A dirty cell is a cell whose clearance value is changed, it's updated on
+		// all related quadtree maps.
+		[[nodiscard]] std::size_t NumDirtyCells() const { return impl.NumDirtyCells(); }
+
+		// Collects the memory usage and topology statistics of all managed quadtree maps, clearance
+		// fields and dirty queues. It walks all nodes and gates, don't call it in a hot path.
+		[[nodiscard]] QuadtreeMapXStats Stats() const;
+
 		// Find a quadtree map supporting given agent size and terrain types.
 		// Returns nullptr if not found.
 		// If there are multiple maps support the given walkableTerrainTypes, the one with largest subset
@@ -240,6 +403,24 @@ namespace QDPF
 	// Signature: std::function<void(const QdNode *node)>;
 	using NodeVisitor = Internal::QdNodeVisitor;
 
+	//////////////////////////////////////
+	/// PathfinderStats
+	//////////////////////////////////////
+
+	// PathfinderStats collects the statistics of a path finding query, for both path finders.
+	// Pass its address to a path finder's Reset(), it's cleared there, and then filled by the
+	// following Compute calls until the next Reset().
+	//
+	// Fields:
+	//  * NodeSearch and GateSearch: counters of the search on the node graph and the gate graph:
+	//      NumPushedVertices, NumPoppedVertices, NumStaleVertices (popped but already visited),
+	//      NumVisitedNeighbours and NumFilteredNeighbours (rejected since not on the node path or
+	//      node flow field).
+	//  * NumTmpEdges: number of edges connecting the start/target to gates, created by Reset().
+	//  * ResetUs, NodeStageUs, GateStageUs and FinalStageUs: time cost of each stage in microseconds.
+	using Internal::PathfinderStats;
+	using Internal::SearchStats;
+
 	//////////////////////////////////////
 	/// AStarPathFinder
 	//////////////////////////////////////
@@ -279,8 +460,9 @@ namespace QDPF
 		//  * The agentSize is the size of the pathfinding agent.
 		//  * The walkableTerrainTypes is the bitwise OR sum of all terrain type values that the
 		//    pathfinding agent can walk.
+		//  * The stats is optional, to collect the statistics of this query (see PathfinderStats).
 		[[nodiscard]] int Reset(int x1, int y1, int x2, int y2, int agentSize,
-			int walkableterrainTypes = 1);
+			int walkableterrainTypes = 1, PathfinderStats* stats = nullptr);
 
 		// ComputeNodeRoutes computes the path of quadtree nodes from the start cell's node to the target
 		// cell's node on the node graph.
@@ -300,8 +482,23 @@ namespace QDPF
 		//   1. faster (but less optimal).
 		//   2. fast checking if the target is reachable.
 		//   3. optimize the following ComputeGateRoutes(useNodePath=true) call.
+		//
+		// If the node distance oracle covers the two nodes (see QuadtreeMapX.BuildNodeDistanceOracle),
+		// the path is walked on its tables without a search, and it's the shortest on the node graph.
 		[[nodiscard]] int ComputeNodeRoutes(NodePath& nodePath);
 
+		// ComputeNodeDistance computes the cost of the node path from the start cell's node to the
+		// node of cell (x,y), the same as ComputeNodeRoutes would return for the target (x,y), without
+		// collecting the path. The target given to Reset() is not used. It's a table lookup if the node
+		// distance oracle covers the two nodes (see QuadtreeMapX.BuildNodeDistanceOracle), e.g. to
+		// score many candidate targets by distance after a single Reset().
+		//
+		// Returns:
+		//  * Returns -1 if unreachable.
+		//  * Returns -1 if either of start and given cells are out of bound.
+		//  * Returns the approximate cost on the node graph level.
+		[[nodiscard]] int ComputeNodeDistance(int x, int y);
+
 		// ComputeGateRoutes computes the route cells from (x1,y1) to (x2,y2) on the gate graph.
 		//
 		// Reset() should be called in advance to call this api.
@@ -313,6 +510,8 @@ namespace QDPF
 		//   * Sets a non-empty nodePath computed by ComputeGateRoutes() to optimize the performance.
 		//     It will find path only over gate cells on the node path, this the path finding is much
 		//     faster, but less optimal.
+		//   * Without a node path, it searches on the contraction hierarchy of the map if it's built
+		//     and up to date (see QuadtreeMapX.BuildContractionHierarchy), the path is optimal as well.
 		//
 		// Returns:
 		//   * Returns -1 if the path finding is failed.
@@ -326,6 +525,16 @@ namespace QDPF
 		[[nodiscard]] int ComputeGateRoutes(GatePath& path, const NodePath& nodePath);
 		[[nodiscard]] int ComputeGateRoutes(GatePath& path);
 
+		// SetBidirectional sets whether ComputeGateRoutes searches from the start and the target at
+		// the same time, until the two frontiers meet (bidirectional A*). It's off by default.
+		// The gains are modest: on open and random maps it pops about 15% fewer gates and is faster,
+		// on rooms and mazes it pops nearly as many and can be slower, since the routes wind far from
+		// the straight lines. The rounded euclidean heuristic isn't exactly consistent, so the returned
+		// distance may differ from the single direction one by a few cost units, and the path may
+		// differ as well.
+		// The setting is kept across Reset() calls.
+		void SetBidirectional(bool bidirectional);
+
 	private:
 		const QuadtreeMapX&			  mx;
 		Internal::AStarPathFinderImpl impl;
@@ -386,6 +595,7 @@ namespace QDPF
 		//   * The agentSize is the size of the pathfinding agents.
 		//   * The walkableTerrainTypes is the bitwise OR sum of all terrain type values that the
 		//     pathfinding agents can walk.
+		//   * The stats is optional, to collect the statistics of this query (see PathfinderStats).
 		//
 		// A path finder always works on a single QuadtreeMap at the same time.
 		// We must call Reset() before changing to another kind of {agent-size, terrains, destination
@@ -395,7 +605,7 @@ namespace QDPF
 		// destination rectangle, we should group them by {agent size, terrain types}, and call flow path
 		// finder for each.
 		[[nodiscard]] int Reset(int x2, int y2, const Rectangle& qrange, int agentSize,
-			int walkableterrainTypes = 1);
+			int walkableterrainTypes = 1, PathfinderStats* stats = nullptr);
 
 		// ~~~~~~~~~~~~~~~~~~~~~~~ Node Graph Level (Optional) ~~~~~~~~~~~~~~
 